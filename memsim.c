@@ -8,10 +8,30 @@
 #include <assert.h>
 #include <string.h>
 #include <math.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#ifdef __SSSE3__
+#include <tmmintrin.h>
+#endif
+#ifdef MEMSIM_ZLIB
+#include <zlib.h>
+#endif
+#include "memsim.h"
 
-#define PAGESIZEBITS 12			// page size = 4Kbytes
+#define PAGESIZEBITS 12			// 기본 page size = 4Kbytes. -P로 바꾼다
+#define MAXPAGESIZEBITS 30		// 가장 큰 page size = 1Gbytes
 #define VIRTUALADDRBITS 32		// virtual address space size = 4Gbytes
 #define PAGETABLESIZE 1048576	// one-level의 PageTableSize = 2^20
+#define RADIX_MAXLEVELS 6		// N-level radix page table의 최대 level 수
 
 // PT의 entry구조체. two-level이면 1st PT의 entry가 2nd PT를 가리켜야 하므로 *secondLevelPageTable 사용
 struct pageTableEntry {
@@ -27,15 +47,119 @@ struct pageTableEntry2 {
 	int frameNumber;
 };
 
-// RAM의 frame Page 구조체. Doubly Linked List 형식
-struct framePage {
-	int number;			// frame number
-	int pid;			// Process id that owns the frame
-	int virtualPageNumber;			// virtual page number using the frameame
-	int fVPN;
-	int sVPN;
-	struct framePage *lruLeft;	// for LRU circular doubly linked list
-	struct framePage *lruRight; // for LRU circular doubly linked list
+// one-level의 packed PTE. 32bit 하나에 valid/dirty/referenced bit와 frame 번호를 넣는다
+typedef uint32_t pte_t;
+#define PTE_VALID (1u << 31)
+#define PTE_DIRTY (1u << 30)
+#define PTE_REFERENCED (1u << 29)
+#define PTE_FRAMEMASK (PTE_REFERENCED - 1)	// frame 번호 (2^29 frame까지)
+#define MAXFRAMEBITS 29		// PTE_FRAMEMASK에 들어가는 frame 번호의 bit 수
+
+// one-level table은 PTE chunk들의 directory. chunk는 처음 매핑될 때 만들어지므로 건드리지 않은 영역은 메모리를 쓰지 않는다
+#define PTECHUNKBITS 10						// chunk 하나 = 1024 PTE = 4Kbytes
+#define PTECHUNKSIZE (1 << PTECHUNKBITS)
+#define PTEDIRSIZE (PAGETABLESIZE >> PTECHUNKBITS)
+
+// FIFO/LRU 원형 list의 link. frame 번호로 연결한다
+struct frameLink {
+	uint32_t prev, next;
+};
+
+// RAM의 frame table. frame 번호로 index하는 배열들 (struct of arrays).
+// 번호가 nUsedFrame 이상인 frame은 아직 쓰지 않았으므로 초기화하지 않는다
+struct frameTable {
+	int *pid;					// Process id that owns the frame
+	int64_t *vpn;				// virtual page number using the frame. 매핑된 page가 없으면 -1
+	unsigned char *dirty;		// 매핑된 뒤 write access가 있었음. 내보낼 때 write-back 필요
+	uint64_t **pte;				// N-level radix table에서 이 frame을 가리키는 leaf entry
+	struct frameLink *link;		// for FIFO/LRU circular doubly linked list
+	unsigned char *filled;		// fault 없이 채운 뒤 아직 access되지 않은 page: FILL_THP, FILL_PREFETCH (THP나 prefetch를 켰을 때만)
+};
+
+#define FILL_THP 1				// THP 승격으로 채움
+#define FILL_PREFETCH 2			// prefetcher가 채움
+
+// binary trace 파일 형식. header 뒤에 record가 nrecords개 이어진다 (host byte order)
+#define BINTRACE_MAGIC "MSBT"
+#define BINTRACE_VERSION 3		// version 2부터 64bit 주소, version 3부터 timestamp
+
+struct binTraceHeader {
+	char magic[4];				// "MSBT"
+	uint32_t version;			// BINTRACE_VERSION
+	uint64_t nrecords;			// the number of records following the header
+};
+
+struct binTraceRecord {
+	uint64_t addr;				// virtual address
+	uint64_t rwTime;			// 하위 8bit는 'R' or 'W', 상위 56bit는 timestamp
+};
+
+// 압축 trace 파일 형식. header, block들, block index 순서. block은 따로 decode할 수 있다 (delta 기준을 block마다 새로 잡는다).
+// record 하나는 varint A = zigzag(VPN delta) << 2 | write << 1 | (timestamp delta != 1), varint B = zigzag(offset delta),
+// timestamp delta가 1이 아니면 varint C = zigzag(timestamp delta). VPN/offset은 CTRACE_PAGEBITS로 나눈다
+#define CTRACE_MAGIC "MSCT"
+#define CTRACE_VERSION 1
+#define CTRACE_ZLIB 1			// block을 zlib으로 한 번 더 압축
+#define CTRACE_BLOCK 65536		// block 하나의 record 수
+#define CTRACE_PAGEBITS 12
+#define CTRACE_MAXRECORD 24		// encode한 record의 최대 bytes
+
+#define IS_WRITE(rw) ((rw) == 'W' || (rw) == 'w')
+
+struct ctraceHeader {
+	char magic[4];				// "MSCT"
+	uint32_t version;			// CTRACE_VERSION
+	uint32_t flags;				// CTRACE_ZLIB
+	uint32_t blockRecords;		// block 하나의 최대 record 수
+	uint64_t nrecords;
+	uint64_t nblocks;
+	uint64_t indexOffset;		// block index의 파일 위치
+};
+
+struct ctraceBlock {
+	uint64_t offset;			// block의 파일 위치
+	uint64_t firstRecord;		// block의 첫 record 번호
+	uint32_t storedSize;		// 파일에 저장된 bytes (zlib이면 압축한 크기)
+	uint32_t rawSize;			// varint encoding의 bytes
+	uint32_t nrecords;
+	uint32_t reserved;
+};
+
+// 압축 trace의 decoder 상태. block을 하나씩 decode해 두고 record를 꺼낸다
+struct ctrace {
+	struct ctraceHeader header;
+	struct ctraceBlock *index;
+	uint64_t block;				// 다음에 decode할 block
+	unsigned char *stored, *raw;
+	uint64_t *addr, *time;		// decode한 block
+	char *rw;
+	int len, pos;				// decode한 record 수와 다음에 꺼낼 record
+};
+
+#define TRACE_TEXT 0
+#define TRACE_BINARY 1
+#define TRACE_COMPRESSED 2
+
+#define TEXTBUFSIZE (1 << 20)	// text trace를 read()하는 단위
+#define TEXTMAXLINE 64			// buffer에 이만큼 남으면 미리 채운다
+
+// trace 입력. text는 block 단위로 read()해서 직접 parsing하고, binary는 mmap한 record를 그대로 읽는다.
+// 압축 trace는 block 단위로 pread해서 decode한다
+struct traceFile {
+	int format;					// TRACE_TEXT, TRACE_BINARY or TRACE_COMPRESSED
+	int fd;						// text, compressed trace
+	char *buf;					// text read buffer (TEXTBUFSIZE + padding)
+	size_t bufLen, bufPos;
+	int eof;					// read()가 파일의 끝에 도달했는지
+	void *map;					// mmaped binary trace
+	size_t mapSize;
+	const struct binTraceRecord *records;
+	uint64_t nrecords;
+	uint64_t pos;				// next record to read
+	uint64_t time;				// 마지막으로 읽은 record의 timestamp. trace에 없으면 record 번호
+	uint64_t nread;				// text: 읽은 record 수
+	int stream;					// pipe, FIFO, terminal처럼 한 번만 읽을 수 있는 입력 (rewind할 수 없다)
+	struct ctrace *ct;			// compressed trace
 };
 
 struct invertedPageTableEntry {
@@ -45,802 +169,5553 @@ struct invertedPageTableEntry {
 	struct invertedPageTableEntry *next;
 };
 
+// open addressing inverted page table의 slot
+struct iptSlot {
+	uint64_t key;				// pageKey(pid, vpn). 빈 slot은 PAGEMAP_EMPTY
+	int frameNumber;
+};
+
 // Process 정보들 저장할 구조체
 struct procEntry {
 	char *traceName;			// the memory trace name
 	int pid;					// process (trace) id
-	int ntraces;				// the number of memory traces
+	long long ntraces;			// the number of memory traces
 	int num2ndLevelPageTable;	// The 2nd level page created(allocated);
-	int numIHTConflictAccess; 	// The number of Inverted Hash Table Conflict Accesses
-	int numIHTNULLAccess;		// The number of Empty Inverted Hash Table Accesses
-	int numIHTNonNULLAcess;		// The number of Non Empty Inverted Hash Table Accesses
-	int numPageFault;			// The number of page faults
-	int numPageHit;				// The number of page hits
+	long long numIHTConflictAccess;	// The number of Inverted Hash Table Conflict Accesses
+	long long numIHTNULLAccess;	// The number of Empty Inverted Hash Table Accesses
+	long long numIHTNonNULLAcess;	// The number of Non Empty Inverted Hash Table Accesses
+	long long numPageFault;		// The number of page faults
+	long long numPageHit;			// The number of page hits
+	long long numCleanEviction;	// The number of this process's clean pages evicted
+	long long numDirtyEviction;	// The number of this process's dirty pages evicted (written back)
+	long long numTLBHit;			// The number of translations found in the TLB
+	long long numTLBMiss;			// The number of translations that needed a page table walk
+	long long numPTWalkRef;		// The number of page table memory references made by the walks
+	long long numContextSwitch;	// The number of times this process was switched in
+	long long numPromotion;		// The number of huge page regions promoted (THP)
+	long long numDemotion;		// The number of huge pages split back by an eviction
+	long long numPromoteFill;	// The number of base pages brought in by promotions
+	long long numFaultAvoided;	// The number of promotion-filled pages touched before eviction (faults saved)
+	long long numPrefetch;		// The number of pages prefetched
+	long long numPrefetchUseful;	// The number of prefetched pages accessed before eviction
+	long long numPrefetchHarmful;	// The number of prefetched pages evicted before any access
+	long long numSlowHit;		// The number of accesses that found the page in the slow tier
+	long long numTierPromotion;	// The number of pages migrated from the slow tier to the fast tier
+	long long numTierDemotion;	// The number of pages migrated from the fast tier to the slow tier
+	long long numCacheHit;		// The number of accesses that hit in the physically indexed cache
+	long long numCacheMiss;		// The number of accesses that missed in the cache
+	long long numCacheConflict;	// The number of cache misses that a fully associative cache of the same size would hit
+	int numRadixTable[RADIX_MAXLEVELS];	// The number of radix page tables allocated at each level
 	int eof_valid;				// Check is it the end of the file
 	struct pageTableEntry *firstLevelPageTable;
-	FILE *tracefp;
+	pte_t **oneLevelDir;		// one-level의 PTE chunk directory
+	int numPTEChunk;			// The number of one-level PTE chunks allocated
+	uint64_t *radixRoot;		// N-level radix page table의 최상위 table
+	struct traceFile trace;
 };
 
-struct framePage *oldestFrame; // the oldest frame pointer
-int firstLevelBits, twoLevelBits, phyMemSizeBits, numProcess, nFrame;
+int firstLevelBits, phyMemSizeBits, numProcess, nFrame;
+int pageSizeBits = PAGESIZEBITS;
 int s_flag = 0;
 
-void initPhyMem(struct framePage *phyMem, int nFrame) {
-	int i;
-	for(i = 0; i < nFrame; i++) {
-		phyMem[i].number = i;
-		phyMem[i].pid = -1;
-		phyMem[i].virtualPageNumber = -1;
-		phyMem[i].lruLeft = &phyMem[(i-1+nFrame) % nFrame];
-		phyMem[i].lruRight = &phyMem[(i+1+nFrame) % nFrame];
-	}
+// I/O 비용 모델 (단위 ns). -C로 바꾼다
+struct costModel {
+	double faultService;		// page fault 한 번 처리 (disk에서 page 읽기)
+	double writeBack;			// dirty page 하나를 disk에 쓰기
+	double memAccess;			// memory access 한 번
+	double fillRead;			// fault 없이 page 하나 읽기 (prefetch, THP 승격). 음수이면 faultService
+};
+struct costModel cost = { 8000000.0, 8000000.0, 100.0, -1.0 };
 
-	oldestFrame = &phyMem[0];
-}
+// TLB 설정. -T로 켠다 (entries가 0이면 TLB 없이 page table만 시뮬레이션)
+struct tlbConfig {
+	int entries;
+	int ways;					// set associativity. entries와 같으면 fully associative
+	char policy;				// set 안에서의 replacement: L LRU, F FIFO, R random
+	int asid;					// 1이면 entry를 pid(ASID)로 구분, 0이면 프로세스가 바뀔 때마다 flush
+	double hitNs;				// TLB lookup 시간
+};
+struct tlbConfig tlbConf = { 0, 0, 'L', 1, 1.0 };
 
-void oneLevelVMSim(struct procEntry *procTable, struct framePage *phyMemFrames, char FIFOorLRU) {
-	int i;
-	int eof_cnt = 0;
-	int phyMemCNT = 0;
-	unsigned addr, Vaddr, Paddr, offset;
-	char rw;
-	
-	// PageTable 동적할당으로 생성
-	for(i=0; i < numProcess; i++)
-		procTable[i].firstLevelPageTable = (struct pageTableEntry *)malloc(sizeof(struct pageTableEntry) * PAGETABLESIZE);
+// inverted page table 구성. -I로 바꾼다
+struct iptConfig {
+	char backend;				// c chained (frame마다 entry 하나), o open addressing (linear probing)
+	char hash;					// m (vpn + pid) % size, x mix64, f Fibonacci
+	int slots;					// bucket/slot 개수. 0이면 nFrame
+	int set;					// -I가 주어졌으면 report에 구성을 출력
+};
+struct iptConfig iptConf = { 'c', 'm', 0, 0 };
 
-	if(FIFOorLRU == 'F') {	// FIFO method
-		while(eof_cnt != numProcess) {	// 프로세스의 개수만큼 eof를 읽으면 종료. 
-			for(i=0; i < numProcess; i++) {
-				if(procTable[i].eof_valid == 1)	// 먼저 끝난 더 이상 반복문을 프로세스는 수행하지 않는다.
-					continue;
+// N-level radix page table 구성. -L로 바꾼다 (기본은 x86-64 4-level paging, 48bit virtual address)
+struct radixConfig {
+	int levels;
+	int bits[RADIX_MAXLEVELS];	// 위 level부터 각 level의 index로 쓰는 VPN bit 수
+	int vaBits;					// page offset bit 수 + bits의 합
+	int set;					// -L로 지정했는지. 아니면 page 크기에 맞춰 48bit를 나눈다
+};
+struct radixConfig radixConf = { 4, {9, 9, 9, 9}, 48, 0 };
 
-				if(fscanf(procTable[i].tracefp, "%x %c", &addr, &rw) == EOF) {	// 파일의 끝을 읽으면 continue.
-					procTable[i].eof_valid = 1;
-					eof_cnt++;
-					continue;
-				}
-				else {
-					// phyMemSizeBits에 따라서 Vaddr 설정.
-					
-					//if(phyMemSizeBits == 32)
-					Vaddr = addr >> PAGESIZEBITS;
-					offset = addr & 0xfff; // offset
-
-					// pageHit
-					if(procTable[i].firstLevelPageTable[Vaddr].valid == '1')// && procTable[i].pid == phyMemFrames[procTable[i].firstLevelPageTable[Vaddr].frameNumber].pid)
-						procTable[i].numPageHit++;
-
-					// pageFault
-					else {
-						procTable[i].numPageFault++;
-
-						// pageFault 발생 시 oldestFrame을 맵핑해주고 해당 framePage에 맵핑된 procTable 정보 저장
-						if(oldestFrame->virtualPageNumber != -1)
-							procTable[oldestFrame->pid].firstLevelPageTable[oldestFrame->virtualPageNumber].valid = '0';
-
-						procTable[i].firstLevelPageTable[Vaddr].frameNumber = oldestFrame->number;
-						procTable[i].firstLevelPageTable[Vaddr].valid = '1';
-						oldestFrame->virtualPageNumber = Vaddr;
-						oldestFrame->pid = procTable[i].pid;
-						oldestFrame = oldestFrame->lruRight;
-					}
+// working set / PFF allocation의 parameter. -W로 바꾼다 (단위는 프로세스의 access 수)
+struct allocConfig {
+	uint64_t tau;				// working set window
+	uint64_t pffInterval;		// PFF: fault 간격이 이보다 짧으면 resident set을 늘린다
+	uint64_t sample;			// resident set 크기를 기록하는 간격
+};
+struct allocConfig allocConf = { 10000, 100, 10000 };
 
-					Vaddr = procTable[i].firstLevelPageTable[Vaddr].frameNumber << PAGESIZEBITS;
-					Paddr = Vaddr + offset;
+// trace들을 합치는 scheduler. -Q로 바꾼다 (기본은 프로세스마다 access 하나씩 round-robin)
+struct schedConfig {
+	char mode;					// r round-robin, t trace의 timestamp 순서로 merge
+	int quantum;				// round-robin: 한 번 차례가 오면 연속으로 실행하는 access 수
+	int *weight;				// 프로세스별 quantum 배수 (priority weight). NULL이면 모두 1
+	int nweight;
+};
+struct schedConfig schedConf = { 'r', 1, NULL, 0 };
 
-					procTable[i].ntraces++;
+// trace를 읽는 reader thread들. -D로 켠다. 프로세스마다 ring buffer에 decode해두고 scheduler는 ring에서만 꺼낸다
+struct ingestConfig {
+	int readers;				// reader thread 수. 0이면 scheduler가 직접 읽는다
+	int depth;					// 프로세스별 ring의 batch 수
+	int batch;					// batch 하나의 access 수
+};
+struct ingestConfig ingestConf = { 0, 8, 4096 };
 
-					// -s option print statement
-					if(s_flag)
-						printf("One-Level procID %d traceNumber %d virtual addr %x physical addr %x\n", i, procTable[i].ntraces, addr, Paddr);
-				}
-			}
-		}
-	}
-	
-	else {	// LRU method
-		while(eof_cnt != numProcess) {	// 프로세스의 개수만큼 eof를 읽으면 종료. 
-			for(i=0; i < numProcess; i++) {
-				if(procTable[i].eof_valid == 1)	// 먼저 끝난 더 이상 반복문을 프로세스는 수행하지 않는다.
-					continue;
+// local replacement. -l로 켠다. 프로세스마다 자기 frame quota 안에서만 교체하므로 프로세스별로 따로 시뮬레이션할 수 있다
+struct localConfig {
+	char alloc;					// 0 global replacement, e 균등, w footprint(working set) 비례, u 사용자 지정
+	int *quota;					// 'u'일 때 프로세스별 frame 수
+	int nquota;
+};
+struct localConfig localConf = { 0, NULL, 0 };
 
-				if(fscanf(procTable[i].tracefp, "%x %c", &addr, &rw) == EOF)	// 파일의 끝을 읽으면 continue.
-				{
-					procTable[i].eof_valid = 1;
-					eof_cnt++;
-					continue;
-				}
-				else
-				{
-					Vaddr = addr >> PAGESIZEBITS;
-					offset = addr & 0xfff; // offset
-
-					// pageHit
-					if(procTable[i].firstLevelPageTable[Vaddr].valid == '1')// && procTable[i].pid == phyMemFrames[procTable[i].firstLevelPageTable[Vaddr].frameNumber].pid)
-					{
-						procTable[i].numPageHit++;
-
-						if(oldestFrame == &phyMemFrames[procTable[i].firstLevelPageTable[Vaddr].frameNumber])
-							oldestFrame = oldestFrame->lruRight;
-
-						else {
-							unsigned temp = procTable[i].firstLevelPageTable[Vaddr].frameNumber;
-
-							phyMemFrames[temp].lruLeft->lruRight = phyMemFrames[temp].lruRight;
-							phyMemFrames[temp].lruRight->lruLeft = phyMemFrames[temp].lruLeft;
-							phyMemFrames[temp].lruRight = oldestFrame;
-							phyMemFrames[temp].lruLeft = oldestFrame->lruLeft;
-							oldestFrame->lruLeft->lruRight = &phyMemFrames[temp];
-							oldestFrame->lruLeft = &phyMemFrames[temp];
-						}
-					}
-					
-					// pageFault
-					else
-					{
-						procTable[i].numPageFault++;
-
-						// pageFault 발생 시 oldestFrame을 맵핑해주고 해당 framePage에 맵핑된 procTable 정보 저장
-						if(oldestFrame->virtualPageNumber != -1)
-							procTable[oldestFrame->pid].firstLevelPageTable[oldestFrame->virtualPageNumber].valid = '0';
-
-						procTable[i].firstLevelPageTable[Vaddr].frameNumber = oldestFrame->number;
-						procTable[i].firstLevelPageTable[Vaddr].valid = '1';
-						oldestFrame->virtualPageNumber = Vaddr;
-						oldestFrame->pid = procTable[i].pid;
-						oldestFrame = oldestFrame->lruRight;
-					}
-					
-					Vaddr = procTable[i].firstLevelPageTable[Vaddr].frameNumber << PAGESIZEBITS;
-					Paddr = Vaddr + offset;
+// transparent huge page 승격. -H로 켠다 (one-level과 N-level radix만).
+// base page 2^THP_ORDER개의 정렬된 영역(4K page이면 2MB)에서 threshold개 이상이 resident가 되면 나머지 page도 채워서
+// huge page로 만든다. huge page는 TLB entry 하나로 변환하고, 그 중 base page 하나라도 내보내면 다시 base page들로 쪼갠다
+#define THP_ORDER 9
+#define THP_COUNT 0xffffffffULL		// region map value의 하위 32bit: resident base page 수
+#define THP_HUGE (1ULL << 32)		// region이 huge page로 매핑됨
+#define THP_TLBKEY (1ULL << 63)		// huge page의 TLB key 표시 (pid는 15bit를 넘지 않는다)
 
-					procTable[i].ntraces++;
+struct thpConfig {
+	int threshold;				// 승격에 필요한 resident base page 수. 0이면 THP 없음
+};
+struct thpConfig thpConf = { 0 };
 
-					// -s option print statement
-					if(s_flag)
-						printf("One-Level procID %d traceNumber %d virtual addr %x physical addr %x\n", i, procTable[i].ntraces, addr, Paddr);
-				}
-			}
-		}
+// page fault 때 다음에 쓸 page를 미리 읽는 prefetcher. -F로 켠다
+struct prefetchConfig {
+	char kind;					// 0 없음, n next-N page, s 프로세스별 stride, m Markov (miss 다음에 온 miss)
+	int degree;					// miss 한 번에 prefetch하는 page 수
+};
+struct prefetchConfig prefetchConf = { 0, 4 };
+
+// 두 단계 memory. -M으로 켠다. frame table이 빠른 tier(DRAM, cost.memAccess)이고 그 아래에 느린 tier를 둔다
+struct tierConfig {
+	int frames;					// slow tier의 page 수. 0이면 tier 없음
+	char promote;				// f slow tier에서 threshold번 access되면, r 마지막 access 뒤 threshold access 안에 다시 access되면 올린다
+	uint64_t threshold;
+	double slowNs;				// slow tier access 한 번
+};
+struct tierConfig tierConf = { 0, 'f', 2, 300.0 };
+
+// physical address로 index하는 cache. -K로 켠다
+struct cacheConfig {
+	int bytes;					// 0이면 cache 없음
+	int ways;
+	int lineBytes;
+	int coloring;				// 1이면 FIFO/LRU가 page coloring으로 victim frame을 고른다
+};
+struct cacheConfig cacheConf = { 0, 16, 64, 0 };
+
+// SHARDS 식 공간 sampling. -R로 켠다. hash가 threshold 이하인 (pid, VPN)의 access만 시뮬레이션한다
+struct sampleConfig {
+	double rate;				// 고정 sampling rate. 0이면 sampling 없음
+	uint64_t smax;				// 0이 아니면 rate 대신 서로 다른 page를 이 개수만큼 남기는 고정 크기 sample
+};
+struct sampleConfig sampleConf = { 0.0, 0 };
+
+// -s의 translation 출력. -S로 형식과 filter를, -o로 파일을 바꾼다
+struct sinkConfig {
+	char format;				// t text (printf와 같은 줄), b binary record
+	int faultsOnly;				// 1이면 page fault만
+	int pid;					// 0 이상이면 이 프로세스만
+	FILE *fp;					// 출력할 곳. NULL이면 stdout
+};
+struct sinkConfig sinkConf = { 't', 0, -1, NULL };
+
+int convertTrace(const char *textName, const char *binName);
+
+// binary trace 파일을 mmap. binary 형식이 아니면 -1
+int mapBinaryTrace(struct traceFile *trace, const char *binName) {
+	struct binTraceHeader *header;
+	struct stat st;
+	void *map;
+	int fd;
+
+	if((fd = open(binName, O_RDONLY)) < 0)
+		return -1;
+	if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct binTraceHeader)) {
+		close(fd);
+		return -1;
 	}
-	
-	for(i=0; i < numProcess; i++) {
-		printf("**** %s *****\n",procTable[i].traceName);
-		printf("Proc %d Num of traces %d\n",i,procTable[i].ntraces);
-		printf("Proc %d Num of Page Faults %d\n",i,procTable[i].numPageFault);
-		printf("Proc %d Num of Page Hit %d\n",i,procTable[i].numPageHit);
-		assert(procTable[i].numPageHit + procTable[i].numPageFault == procTable[i].ntraces);
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(map == MAP_FAILED)
+		return -1;
+
+	header = (struct binTraceHeader *)map;
+	if(memcmp(header->magic, BINTRACE_MAGIC, 4) || header->version != BINTRACE_VERSION
+			|| sizeof(*header) + header->nrecords * sizeof(struct binTraceRecord) > (uint64_t)st.st_size) {
+		munmap(map, st.st_size);
+		return -1;
 	}
+	madvise(map, st.st_size, MADV_SEQUENTIAL);
 
-	for(i=0; i < numProcess; i++)
-		rewind(procTable[i].tracefp);
+	trace->format = TRACE_BINARY;
+	trace->fd = -1;
+	trace->buf = NULL;
+	trace->ct = NULL;
+	trace->map = map;
+	trace->mapSize = st.st_size;
+	trace->records = (const struct binTraceRecord *)(header + 1);
+	trace->nrecords = header->nrecords;
+	trace->pos = 0;
+	trace->time = trace->nread = 0;
+	return 0;
 }
 
-void twoLevelVMSim(struct procEntry *procTable, struct framePage *phyMemFrames) {
-	int i;
-	int eof_cnt = 0;
-	int firstLevelPageTableSize, twoLevelPageTableSize;
-	unsigned addr, Vaddr, Paddr, offset, fVPN, sVPN;
-	char rw;
-	
-	twoLevelBits = 32 - PAGESIZEBITS - firstLevelBits;
-	// Page Table Size 지정
-	firstLevelPageTableSize = 1 << firstLevelBits;
-	twoLevelPageTableSize = 1 << twoLevelBits;
+static inline uint64_t zigzag(int64_t v) {
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
 
-	// first Page Table 동적할당으로 생성
-	for(i=0; i < numProcess; i++)
-		procTable[i].firstLevelPageTable = (struct pageTableEntry *)malloc(sizeof(struct pageTableEntry) * firstLevelPageTableSize);
+static inline int64_t unzigzag(uint64_t v) {
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
 
-	while(eof_cnt != numProcess)	// 프로세스의 개수만큼 eof를 읽으면 종료.
-	{
-		for(i=0; i < numProcess; i++)
-		{
-			if(procTable[i].eof_valid == 1)	// 먼저 끝난 더 이상 반복문을 프로세스는 수행하지 않는다.
-				continue;
+static inline unsigned char *putVarint(unsigned char *p, uint64_t v) {
+	while(v >= 0x80) {
+		*p++ = (unsigned char)v | 0x80;
+		v >>= 7;
+	}
+	*p++ = (unsigned char)v;
+	return p;
+}
 
-			if(fscanf(procTable[i].tracefp, "%x %c", &addr, &rw) == EOF)	// 파일의 끝을 읽으면 continue.
-			{
-				procTable[i].eof_valid = 1;
-				eof_cnt++;
-				continue;
-			}
-			else
-			{		
-				fVPN = (addr >> PAGESIZEBITS) >> twoLevelBits;
-				sVPN = (addr << firstLevelBits) >> PAGESIZEBITS >> firstLevelBits;
-				offset = addr & 0xfff;	// offset = 하위 12bits
-
-				// pageHit
-				if(procTable[i].firstLevelPageTable[fVPN].valid == '1')
-				{
-					// second PageTable 접근
-					if(procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].valid == '1')	// page Hit
-					{
-						procTable[i].numPageHit++;
-
-						if(oldestFrame == &phyMemFrames[procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber])
-							oldestFrame = oldestFrame->lruRight;
-
-						else {
-							unsigned temp = procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber;
-
-							phyMemFrames[temp].lruLeft->lruRight = phyMemFrames[temp].lruRight;
-							phyMemFrames[temp].lruRight->lruLeft = phyMemFrames[temp].lruLeft;
-							phyMemFrames[temp].lruRight = oldestFrame;
-							phyMemFrames[temp].lruLeft = oldestFrame->lruLeft;
-							oldestFrame->lruLeft->lruRight = &phyMemFrames[temp];
-							oldestFrame->lruLeft = &phyMemFrames[temp];
-						}
-					}
+// end를 넘거나 64bit를 넘으면 NULL
+static inline const unsigned char *getVarint(const unsigned char *p, const unsigned char *end, uint64_t *v) {
+	uint64_t x = 0;
+	int shift;
 
-					else	// PT2에서의 page Fault
-					{
-						procTable[i].numPageFault++;
-
-						// pageFault 발생 시 oldestFrame을 맵핑해주고 해당 framePage에 맵핑된 procTable 정보 저장
-						if(oldestFrame->virtualPageNumber != -1)	// oldestFrame에 맵핑돼 있던 PT valid = 0으로 수정.
-							procTable[oldestFrame->pid].firstLevelPageTable[oldestFrame->fVPN].secondLevelPageTable[oldestFrame->sVPN].valid = '0';
-
-						procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber = oldestFrame->number;
-						procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].valid = '1';
-						procTable[i].firstLevelPageTable[fVPN].valid = '1';
-						oldestFrame->virtualPageNumber = (addr >> PAGESIZEBITS);
-						oldestFrame->fVPN = fVPN;
-						oldestFrame->sVPN = sVPN;
-						oldestFrame->pid = procTable[i].pid;
-						oldestFrame = oldestFrame->lruRight;
-					}
-				}
+	for(shift = 0; p < end && shift < 64; shift += 7) {
+		x |= (uint64_t)(*p & 0x7f) << shift;
+		if(!(*p++ & 0x80)) {
+			*v = x;
+			return p;
+		}
+	}
+	return NULL;
+}
 
+// record n개를 raw에 encode한다. raw는 n * CTRACE_MAXRECORD bytes 이상. encode한 bytes를 돌려준다
+size_t encodeCtraceBlock(const uint64_t *addrs, const char *rws, const uint64_t *times, int n, uint64_t firstRecord, unsigned char *raw) {
+	uint64_t prevVpn = 0, prevOffset = 0, prevTime = firstRecord - 1, vpn, offset;
+	unsigned char *p = raw;
+	int k;
 
-				// PT1에서의 page Fault
-				else
-				{
-					procTable[i].numPageFault++;
-
-					// pageFault 발생 시 oldestFrame을 맵핑해주고 해당 framePage에 맵핑된 procTable 정보 저장
-					if(oldestFrame->virtualPageNumber != -1)	// oldestFrame에 맵핑돼 있던 PT valid = 0으로 수정.
-						procTable[oldestFrame->pid].firstLevelPageTable[oldestFrame->fVPN].secondLevelPageTable[oldestFrame->sVPN].valid = '0';
-
-					procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable = (struct pageTableEntry2 *)malloc(sizeof(struct pageTableEntry2) * twoLevelPageTableSize);
-					procTable[i].num2ndLevelPageTable++;
-					procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber = oldestFrame->number;
-					procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].valid = '1';
-					procTable[i].firstLevelPageTable[fVPN].valid = '1';
-					oldestFrame->virtualPageNumber = (addr >> PAGESIZEBITS);
-					oldestFrame->fVPN = fVPN;
-					oldestFrame->sVPN = sVPN;
-					oldestFrame->pid = procTable[i].pid;
-					oldestFrame = oldestFrame->lruRight;
-				}
-			}
+	for(k = 0; k < n; k++) {
+		vpn = addrs[k] >> CTRACE_PAGEBITS;
+		offset = addrs[k] & ((1u << CTRACE_PAGEBITS) - 1);
+		p = putVarint(p, zigzag((int64_t)(vpn - prevVpn)) << 2 | (uint64_t)IS_WRITE(rws[k]) << 1 | (times[k] - prevTime != 1));
+		p = putVarint(p, zigzag((int64_t)(offset - prevOffset)));
+		if(times[k] - prevTime != 1)
+			p = putVarint(p, zigzag((int64_t)(times[k] - prevTime)));
+		prevVpn = vpn;
+		prevOffset = offset;
+		prevTime = times[k];
+	}
+	return p - raw;
+}
 
-			procTable[i].ntraces++;
-			Paddr = (procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber << PAGESIZEBITS) + offset;
-			// -s option print statement
-			if(s_flag)
-				printf("Two-Level procID %d traceNumber %d virtual addr %x physical addr %x\n", i, procTable[i].ntraces,addr,Paddr);
-		}
+// block 하나를 읽어서 decode한다. 버퍼는 호출한 쪽 것만 쓰므로 여러 thread가 같은 fd로 동시에 불러도 된다.
+// stored와 raw는 block의 storedSize, rawSize 이상. 손상됐으면 -1
+int decodeCtraceBlock(int fd, uint32_t flags, const struct ctraceBlock *blk, unsigned char *stored, unsigned char *raw,
+		uint64_t *addrs, char *rws, uint64_t *times) {
+	uint64_t prevVpn = 0, prevOffset = 0, prevTime = blk->firstRecord - 1, a, b, c;
+	const unsigned char *p, *end;
+	uint32_t k;
+
+	if(pread(fd, flags & CTRACE_ZLIB ? stored : raw, blk->storedSize, blk->offset) != (ssize_t)blk->storedSize)
+		return -1;
+	if(flags & CTRACE_ZLIB) {
+#ifdef MEMSIM_ZLIB
+		uLongf rawLen = blk->rawSize;
+		if(uncompress(raw, &rawLen, stored, blk->storedSize) != Z_OK || rawLen != blk->rawSize)
+			return -1;
+#else
+		return -1;
+#endif
 	}
-		
-	for(i=0; i < numProcess; i++) {
-		printf("**** %s *****\n",procTable[i].traceName);
-		printf("Proc %d Num of traces %d\n",i,procTable[i].ntraces);
-		printf("Proc %d Num of second level page tables allocated %d\n",i,procTable[i].num2ndLevelPageTable);
-		printf("Proc %d Num of Page Faults %d\n",i,procTable[i].numPageFault);
-		printf("Proc %d Num of Page Hit %d\n",i,procTable[i].numPageHit);
-		assert(procTable[i].numPageHit + procTable[i].numPageFault == procTable[i].ntraces);
+
+	p = raw;
+	end = raw + blk->rawSize;
+	for(k = 0; k < blk->nrecords; k++) {
+		if((p = getVarint(p, end, &a)) == NULL || (p = getVarint(p, end, &b)) == NULL)
+			return -1;
+		c = 2;	// zigzag(1)
+		if((a & 1) && (p = getVarint(p, end, &c)) == NULL)
+			return -1;
+		prevVpn += unzigzag(a >> 2);
+		prevOffset += unzigzag(b);
+		prevTime += unzigzag(c);
+		addrs[k] = prevVpn << CTRACE_PAGEBITS | (prevOffset & ((1u << CTRACE_PAGEBITS) - 1));
+		rws[k] = a & 2 ? 'W' : 'R';
+		times[k] = prevTime;
 	}
+	return p == end ? (int)blk->nrecords : -1;
+}
 
-	for(i=0; i < numProcess; i++)
-		rewind(procTable[i].tracefp);
+// 압축 trace 열기. 압축 형식이 아니면 -1, 압축 trace인데 zlib block을 풀 수 없거나 index가 맞지 않으면 -2
+int openCompressedTrace(struct traceFile *trace, const char *name) {
+	struct ctraceHeader header;
+	struct ctrace *ct;
+	struct stat st;
+	uint64_t b, next = sizeof(header), maxStored = 0, maxRaw = 0;
+	int fd;
+
+	if((fd = open(name, O_RDONLY)) < 0)
+		return -1;
+	if(fstat(fd, &st) < 0 || pread(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || memcmp(header.magic, CTRACE_MAGIC, 4)) {
+		close(fd);
+		return -1;
+	}
+	if(header.version != CTRACE_VERSION || header.blockRecords == 0
+			|| header.indexOffset + header.nblocks * sizeof(struct ctraceBlock) != (uint64_t)st.st_size) {
+		fprintf(stderr, "%s is not a valid compressed trace\n", name);
+		close(fd);
+		return -2;
+	}
+#ifndef MEMSIM_ZLIB
+	if(header.flags & CTRACE_ZLIB) {
+		fprintf(stderr, "%s has zlib blocks; build with -DMEMSIM_ZLIB -lz\n", name);
+		close(fd);
+		return -2;
+	}
+#endif
+
+	ct = (struct ctrace *)calloc(1, sizeof(struct ctrace));
+	ct->header = header;
+	ct->index = (struct ctraceBlock *)malloc(sizeof(struct ctraceBlock) * (header.nblocks ? header.nblocks : 1));
+	if(pread(fd, ct->index, header.nblocks * sizeof(struct ctraceBlock), header.indexOffset) != (ssize_t)(header.nblocks * sizeof(struct ctraceBlock)))
+		goto bad;
+	// block들이 header와 index 사이에 차례대로 있고 record 번호가 이어지는지 확인
+	for(b = 0; b < header.nblocks; b++) {
+		if(ct->index[b].offset != next || ct->index[b].nrecords > header.blockRecords
+				|| ct->index[b].rawSize > (uint64_t)ct->index[b].nrecords * CTRACE_MAXRECORD
+				|| ct->index[b].firstRecord != (b ? ct->index[b - 1].firstRecord + ct->index[b - 1].nrecords : 0))
+			goto bad;
+		next += ct->index[b].storedSize;
+		if(ct->index[b].storedSize > maxStored)
+			maxStored = ct->index[b].storedSize;
+		if(ct->index[b].rawSize > maxRaw)
+			maxRaw = ct->index[b].rawSize;
+	}
+	if(next != header.indexOffset || (header.nblocks
+			&& ct->index[header.nblocks - 1].firstRecord + ct->index[header.nblocks - 1].nrecords != header.nrecords))
+		goto bad;
+
+	ct->stored = (unsigned char *)malloc(maxStored + 1);
+	ct->raw = (unsigned char *)malloc(maxRaw + 1);
+	ct->addr = (uint64_t *)malloc(sizeof(uint64_t) * header.blockRecords);
+	ct->time = (uint64_t *)malloc(sizeof(uint64_t) * header.blockRecords);
+	ct->rw = (char *)malloc(header.blockRecords);
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+	trace->format = TRACE_COMPRESSED;
+	trace->fd = fd;
+	trace->buf = NULL;
+	trace->map = NULL;
+	trace->records = NULL;
+	trace->nrecords = header.nrecords;
+	trace->pos = 0;
+	trace->time = trace->nread = 0;
+	trace->ct = ct;
+	return 0;
+
+bad:
+	fprintf(stderr, "%s is not a valid compressed trace\n", name);
+	free(ct->index);
+	free(ct);
+	close(fd);
+	return -2;
 }
 
+// 다음 block을 decode한다. 더 없으면 0
+int loadCtraceBlock(struct traceFile *trace) {
+	struct ctrace *ct = trace->ct;
+	int n;
 
-void invertedPageVMSim(struct procEntry *procTable, struct framePage *phyMemFrames, int nFrame) {
-	int i;
-	int j;
-	int eof_cnt = 0;
-	int invertedBits;
-	int iptSize;
-	unsigned addr, Vaddr, Paddr, offset, IPN, IPTindex;
-	char rw;
+	if(ct->block == ct->header.nblocks)
+		return 0;
+	n = decodeCtraceBlock(trace->fd, ct->header.flags, &ct->index[ct->block], ct->stored, ct->raw, ct->addr, ct->rw, ct->time);
+	if(n < 0) {
+		fprintf(stderr, "corrupt compressed trace block %llu, stopping this trace\n", (unsigned long long)ct->block);
+		ct->block = ct->header.nblocks;
+		return 0;
+	}
+	ct->block++;
+	ct->len = n;
+	ct->pos = 0;
+	return n;
+}
 
-	invertedBits = 32 - PAGESIZEBITS;
-	iptSize = nFrame;
+// trace 파일 열기. binary 파일이면 바로 mmap하고,
+// text 파일이면서 preferBinary이면 "<name>.bin" cache를 (필요하면 변환해서) mmap한다.
+// "-"는 stdin이다. stdin과 FIFO 같은 stream은 text로 한 번만 읽는다 (binary trace는 mmap해야 하므로 파일로 준다)
+int openTrace(struct traceFile *trace, const char *name, int preferBinary) {
+	char binName[4096];
+	struct stat textSt, binSt;
+	int stdinTrace = !strcmp(name, "-"), ret;
 
-	struct invertedPageTableEntry * invertedPageTable = (struct invertedPageTableEntry *)malloc(sizeof(struct invertedPageTableEntry) * iptSize);
+	trace->stream = 0;
+	if(!stdinTrace && stat(name, &textSt) == 0 && !S_ISREG(textSt.st_mode))
+		trace->stream = 1;
+	if(!stdinTrace && !trace->stream) {
+		if(mapBinaryTrace(trace, name) == 0 || (ret = openCompressedTrace(trace, name)) == 0)
+			return 0;
+		if(ret == -2)	// 압축 trace지만 읽을 수 없음
+			return -1;
+	}
 
-	// initialize invertedPageTable
-	for(i=0; i<iptSize; i++)
-	{
-		invertedPageTable[i].pid = -1;
-		invertedPageTable[i].virtualPageNumber = -1;
-		invertedPageTable[i].frameNumber = -1;
-		invertedPageTable[i].next = NULL;
+	if(preferBinary && !stdinTrace && !trace->stream && snprintf(binName, sizeof(binName), "%s.bin", name) < (int)sizeof(binName)
+			&& stat(name, &textSt) == 0) {
+		// cache가 text보다 오래됐거나 이전 version이면 다시 변환
+		if(stat(binName, &binSt) == 0 && binSt.st_mtime >= textSt.st_mtime && mapBinaryTrace(trace, binName) == 0)
+			return 0;
+		convertTrace(name, binName);
+		if(mapBinaryTrace(trace, binName) == 0)
+			return 0;
 	}
 
-	while(eof_cnt != numProcess)	// 프로세스의 개수만큼 eof를 읽으면 종료.
-	{
-		for(i=0; i < numProcess; i++)
-		{
-			if(procTable[i].eof_valid == 1)	// 먼저 끝난 프로세스는 더 이상 반복문을 수행하지 않는다.
-				continue;
+	// text path
+	trace->format = TRACE_TEXT;
+	trace->ct = NULL;
+	trace->map = NULL;
+	trace->records = NULL;
+	trace->nrecords = trace->pos = 0;
+	trace->time = trace->nread = 0;
+	if(stdinTrace)
+		trace->fd = dup(STDIN_FILENO);
+	else
+		trace->fd = open(name, O_RDONLY);
+	if(trace->fd < 0)
+		return -1;
+	if(fstat(trace->fd, &textSt) == 0 && !S_ISREG(textSt.st_mode))
+		trace->stream = 1;
+	trace->buf = (char *)malloc(TEXTBUFSIZE + TEXTMAXLINE);	// SIMD load가 끝을 넘어가도 되도록 여유를 둔다
+	trace->bufLen = trace->bufPos = 0;
+	trace->buf[0] = '\0';
+	trace->eof = 0;
+	return 0;
+}
 
-			if(fscanf(procTable[i].tracefp, "%x %c", &addr, &rw) == EOF)	// 파일의 끝을 읽으면 continue.
-			{
-				procTable[i].eof_valid = 1;
-				eof_cnt++;
-				continue;
-			}
+// text buffer에 남은 부분을 앞으로 당기고 read()로 채운다. buffer 끝에는 항상 '\0'을 둔다
+void fillTextBuf(struct traceFile *trace) {
+	size_t left = trace->bufLen - trace->bufPos;
+	ssize_t n;
 
-			else
-			{
-				IPN = addr >> PAGESIZEBITS;
-				IPTindex = (IPN + procTable[i].pid) % iptSize;
-				offset = addr & 0xfff;	// offset = 하위 12bits
-				
-				// Entry가 존재하지 않는 경우
-				if(invertedPageTable[IPTindex].next == NULL)
-				{
-					// page fault
-					procTable[i].numIHTNULLAccess++;
-					procTable[i].numPageFault++;
-
-					// 새로운 항목 만들기
-					struct invertedPageTableEntry * newEntry = (struct invertedPageTableEntry *)malloc(sizeof(struct invertedPageTableEntry));
-					newEntry->pid = procTable[i].pid;
-					newEntry->virtualPageNumber = IPN;
-					newEntry->frameNumber = oldestFrame->number;
-					newEntry->next = NULL;
-
-					// 새로운 항목 삽입하기
-					invertedPageTable[IPTindex].next = newEntry;
-
-					// oldest Frame에 맵핑돼있던 항목 삭제
-					if(oldestFrame->virtualPageNumber != -1)
-					{
-						unsigned del_IPTindex;
-						del_IPTindex = (oldestFrame->virtualPageNumber + oldestFrame->pid) % iptSize;
-
-						struct invertedPageTableEntry * del = invertedPageTable[del_IPTindex].next;
-						struct invertedPageTableEntry * del_follow = invertedPageTable[del_IPTindex].next;
-
-						while(del != NULL)
-						{
-							if((del->pid == oldestFrame->pid) && (del->virtualPageNumber == oldestFrame->virtualPageNumber))
-							{
-								if(del != invertedPageTable[del_IPTindex].next)
-								{
-									while(del_follow->next != del)
-										del_follow = del_follow->next;
-
-									del_follow->next = del->next;
-								}
-								else
-									invertedPageTable[del_IPTindex].next = del->next;
-
-								break;
-							}
-							else
-								del = del->next;
-						}
-					}
-					// oldest Frame 정보 갱신
-					oldestFrame->virtualPageNumber = IPN;
-					oldestFrame->pid = procTable[i].pid;
-					oldestFrame = oldestFrame->lruRight;
+	memmove(trace->buf, trace->buf + trace->bufPos, left);
+	trace->bufLen = left;
+	trace->bufPos = 0;
 
-					Paddr = (invertedPageTable[IPTindex].next->frameNumber << PAGESIZEBITS) + offset;
-				}
-				// Entry가 존재하는 경우
-				else
-				{
-					procTable[i].numIHTNonNULLAcess++;
-					procTable[i].numIHTConflictAccess++;
+	// pipe는 조금씩 들어오므로 한 줄 이상 모일 때까지 읽는다
+	while(!trace->eof && trace->bufLen < TEXTBUFSIZE) {
+		n = read(trace->fd, trace->buf + trace->bufLen, TEXTBUFSIZE - trace->bufLen);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n <= 0)
+			trace->eof = 1;
+		else
+			trace->bufLen += n;
+		if(trace->bufLen - left >= TEXTMAXLINE)
+			break;
+	}
+	trace->buf[trace->bufLen] = '\0';
+}
 
-					struct invertedPageTableEntry * searching = invertedPageTable[IPTindex].next;
-					struct invertedPageTableEntry * searching_follow = invertedPageTable[IPTindex].next;
-
-					while(searching != NULL)	// entry 전체 탐색
-					{
-						if((searching->pid == procTable[i].pid) && (searching->virtualPageNumber == IPN))
-						{
-							// Page Hit
-							procTable[i].numPageHit++;
-							/*
-							// 찾은 entry가 맨 앞에 위치해있지 않다면 갱신
-							if(searching != invertedPageTable[IPTindex].next)
-							{
-								while(searching_follow->next != searching)
-									searching_follow = searching_follow->next;
-								searching_follow->next = searching->next;
-								searching->next = invertedPageTable[IPTindex].next;
-								invertedPageTable[IPTindex].next = searching;
-							}
-							*/
-
-							// 찾은 entry에 해당하는 frame 위치 갱신
-							if(oldestFrame == &phyMemFrames[searching->frameNumber])
-								oldestFrame = oldestFrame->lruRight;
-
-							else
-							{
-								unsigned temp = searching->frameNumber;
-
-								phyMemFrames[temp].lruLeft->lruRight = phyMemFrames[temp].lruRight;
-								phyMemFrames[temp].lruRight->lruLeft = phyMemFrames[temp].lruLeft;
-								phyMemFrames[temp].lruRight = oldestFrame;
-								phyMemFrames[temp].lruLeft = oldestFrame->lruLeft;
-								oldestFrame->lruLeft->lruRight = &phyMemFrames[temp];
-								oldestFrame->lruLeft = &phyMemFrames[temp];
-							}
-							
-							Paddr = (searching->frameNumber << PAGESIZEBITS) + offset;
-							break;
-						}
-
-						else
-						{
-							searching = searching->next;
-							if(searching != NULL)
-								procTable[i].numIHTConflictAccess++;
-						}
-					}
+static inline int isTraceSpace(unsigned char c) {	// fscanf가 건너뛰는 whitespace
+	return c == ' ' || (unsigned)(c - '\t') < 5;
+}
 
-					// entry에 존재하지 않는 경우. page fault
-					if(searching == NULL)
-					{
-						procTable[i].numPageFault++;
-
-						// 추가할 새로운 entry 만들기
-						struct invertedPageTableEntry * newEntry = (struct invertedPageTableEntry *)malloc(sizeof(struct invertedPageTableEntry));
-						newEntry->pid = procTable[i].pid;
-						newEntry->virtualPageNumber = IPN;
-						newEntry->frameNumber = oldestFrame->number;
-						newEntry->next = NULL;
-
-						// 새로운 항목 entry맨 앞에 삽입하기
-						newEntry->next = invertedPageTable[IPTindex].next;
-						invertedPageTable[IPTindex].next = newEntry;
-
-						// oldest Frame에 맵핑돼있던 항목 삭제
-						if(oldestFrame->virtualPageNumber != -1)
-						{
-							unsigned del_IPTindex;
-							del_IPTindex = (oldestFrame->virtualPageNumber + oldestFrame->pid) % iptSize;
-							struct invertedPageTableEntry * del = invertedPageTable[del_IPTindex].next;
-							struct invertedPageTableEntry * del_follow = invertedPageTable[del_IPTindex].next;
-
-							while(del != NULL)
-							{
-								if((del->pid == oldestFrame->pid) && (del->virtualPageNumber == oldestFrame->virtualPageNumber))
-								{
-									if(del != invertedPageTable[del_IPTindex].next)
-									{
-										while(del_follow->next != del)
-											del_follow = del_follow->next;
-
-										del_follow->next = del->next;
-									}
-
-									else
-										invertedPageTable[del_IPTindex].next = del->next;
-
-									break;
-								}
-								else
-									del = del->next;
-							}
-						}
-
-						// oldest Frame 정보 갱신
-						oldestFrame->virtualPageNumber = IPN;
-						oldestFrame->pid = procTable[i].pid;
-						oldestFrame = oldestFrame->lruRight;
-
-						Paddr = (invertedPageTable[IPTindex].next->frameNumber << PAGESIZEBITS) + offset;
-					}
-				}
-			}
+static inline int hexValue(unsigned char c) {
+	if((unsigned)(c - '0') < 10)
+		return c - '0';
+	c |= 0x20;
+	if((unsigned)(c - 'a') < 6)
+		return c - 'a' + 10;
+	return -1;
+}
+
+#ifdef __SSSE3__
+// n자리 hex nibble을 8byte 오른쪽 끝으로 정렬하는 shuffle mask (0x80은 0으로 채움)
+static const unsigned char hexAlign[9][16] __attribute__((aligned(16))) = {
+	{0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80, 0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0x80,0x80,0x80,0x80,0x80,0x80,0,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0x80,0x80,0x80,0x80,0x80,0,   1,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0x80,0x80,0x80,0x80,0,   1,   2,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0x80,0x80,0x80,0,   1,   2,   3,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0x80,0x80,0,   1,   2,   3,   4,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0x80,0,   1,   2,   3,   4,   5,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0x80,0,   1,   2,   3,   4,   5,   6,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+	{0,   1,   2,   3,   4,   5,   6,   7,    0x80,0x80,0x80,0x80,0x80,0x80,0x80,0x80},
+};
+
+// p부터 16byte를 한 번에 검사해서 hex 숫자의 개수를 돌려준다. 8자리 이하이면 *value에 값을 구한다
+static inline int hexDecodeSIMD(const char *p, unsigned *value) {
+	const __m128i v = _mm_loadu_si128((const __m128i *)p);
+	const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+	const __m128i isDigit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+	const __m128i isAlpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+	const __m128i nibble = _mm_or_si128(_mm_and_si128(isDigit, _mm_sub_epi8(v, _mm_set1_epi8('0'))),
+			_mm_and_si128(isAlpha, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+	unsigned mask = ~(unsigned)_mm_movemask_epi8(_mm_or_si128(isDigit, isAlpha));
+	int n = __builtin_ctz(mask);	// 첫 번째 hex가 아닌 문자의 위치 (mask의 16번 bit 이상은 항상 1)
+	__m128i aligned, pairs;
+
+	if(n == 0 || n > 8)
+		return n;
+	// nibble 2개씩 byte로, byte 4개를 big endian 32bit로 묶는다
+	aligned = _mm_shuffle_epi8(nibble, _mm_load_si128((const __m128i *)hexAlign[n]));
+	pairs = _mm_maddubs_epi16(aligned, _mm_set1_epi16(0x0110));
+	*value = __builtin_bswap32((unsigned)_mm_cvtsi128_si32(_mm_packus_epi16(pairs, pairs)));
+	return n;
+}
+#endif
+
+// text trace에서 "%llx %c" 한 줄 parsing. fscanf와 같은 결과를 낸다 (파일의 끝이면 EOF, 주소만 있으면 1).
+// 8자리 이하의 (32bit) 주소는 SIMD로, 그보다 긴 64bit 주소는 한 자리씩 읽는다
+int readTextTrace(struct traceFile *trace, uint64_t *addr, char *rw) {
+	const char *p, *end;
+	uint64_t value;
+	int neg, n, digit;
 
-			procTable[i].ntraces++;
-			// -s option print statement
-			if(s_flag)
-				printf("IHT procID %d traceNumber %d virtual addr %x physical addr %x\n", i, procTable[i].ntraces,addr,Paddr);
+retry:
+	if(trace->bufLen - trace->bufPos < TEXTMAXLINE && !trace->eof)
+		fillTextBuf(trace);
+	p = trace->buf + trace->bufPos;
+	end = trace->buf + trace->bufLen;
 
+	while(p < end && isTraceSpace(*p))
+		p++;
+	trace->bufPos = p - trace->buf;
+	if(p == end) {
+		if(trace->eof)
+			return EOF;
+		goto more;
+	}
+
+	value = 0;
+	neg = 0;
+	n = 0;
+#ifdef __SSSE3__
+	unsigned value32 = 0;
+	n = hexDecodeSIMD(p, &value32);
+	value = value32;
+	if(n > 8 || (n == 1 && p[0] == '0' && (p[1] | 0x20) == 'x')) {	// 9자리 이상이나 "0x"는 아래에서 처리
+		n = 0;
+		value = 0;
+	}
+	p += n;
+#endif
+	if(n == 0) {
+		if(*p == '+' || *p == '-') {
+			neg = (*p == '-');
+			p++;
+		}
+		if(p + 2 >= end && !trace->eof)
+			goto more;
+		if(p[0] == '0' && (p[1] | 0x20) == 'x' && hexValue(p[2]) >= 0)
+			p += 2;
+		while((digit = hexValue(*p)) >= 0) {
+			value = (value << 4) | digit;
+			p++;
+			n++;
 		}
+		if(n == 0)
+			goto malformed;
+		if(neg)
+			value = -value;
+	}
+	if(p == end && !trace->eof)	// 숫자가 buffer 끝에서 잘렸을 수 있다
+		goto more;
 
+	while(p < end && isTraceSpace(*p))
+		p++;
+	if(p == end) {
+		if(!trace->eof)
+			goto more;
+		*addr = value;
+		trace->time = trace->nread++;
+		trace->bufPos = p - trace->buf;
+		return 1;
 	}
+	*addr = value;
+	*rw = *p++;
+
+	// 세 번째 field는 10진수 timestamp. 없으면 record 번호를 쓴다
+	while(p < end && (*p == ' ' || *p == '\t'))
+		p++;
+	if(p < end && (unsigned)(*p - '0') < 10)
+		for(trace->time = 0; p < end && (unsigned)(*p - '0') < 10; p++)
+			trace->time = trace->time * 10 + (*p - '0');
+	else
+		trace->time = trace->nread;
+	trace->nread++;
+	trace->bufPos = p - trace->buf;
+	return 2;
+
+more:
+	// 한 줄이 buffer 전체보다 길면 포기
+	if(trace->bufPos == 0 && trace->bufLen == TEXTBUFSIZE)
+		goto malformed;
+	fillTextBuf(trace);
+	goto retry;
+
+malformed:
+	fprintf(stderr, "malformed trace line, stopping this trace\n");
+	trace->bufPos = trace->bufLen;
+	trace->eof = 1;
+	return EOF;
+}
 
-	for(i=0; i < numProcess; i++) {
-		printf("**** %s *****\n",procTable[i].traceName);
-		printf("Proc %d Num of traces %d\n",i,procTable[i].ntraces);
-		printf("Proc %d Num of Inverted Hash Table Access Conflicts %d\n",i,procTable[i].numIHTConflictAccess);
-		printf("Proc %d Num of Empty Inverted Hash Table Access %d\n",i,procTable[i].numIHTNULLAccess);
-		printf("Proc %d Num of Non-Empty Inverted Hash Table Access %d\n",i,procTable[i].numIHTNonNULLAcess);
-		printf("Proc %d Num of Page Faults %d\n",i,procTable[i].numPageFault);
-		printf("Proc %d Num of Page Hit %d\n",i,procTable[i].numPageHit);
-		assert(procTable[i].numPageHit + procTable[i].numPageFault == procTable[i].ntraces);
-		assert(procTable[i].numIHTNULLAccess + procTable[i].numIHTNonNULLAcess == procTable[i].ntraces);
+// trace에서 access 하나 읽기. 파일의 끝이면 EOF
+static inline int readTrace(struct traceFile *trace, uint64_t *addr, char *rw) {
+	if(trace->format == TRACE_BINARY) {
+		if(trace->pos == trace->nrecords)
+			return EOF;
+		*addr = trace->records[trace->pos].addr;
+		*rw = (char)trace->records[trace->pos].rwTime;
+		trace->time = trace->records[trace->pos].rwTime >> 8;
+		trace->pos++;
+		return 2;
+	}
+	if(trace->format == TRACE_COMPRESSED) {
+		struct ctrace *ct = trace->ct;
+		if(ct->pos == ct->len && loadCtraceBlock(trace) == 0)
+			return EOF;
+		*addr = ct->addr[ct->pos];
+		*rw = ct->rw[ct->pos];
+		trace->time = ct->time[ct->pos++];
+		trace->pos++;
+		return 2;
 	}
+	return readTextTrace(trace, addr, rw);
+}
 
-	for(i=0; i < numProcess; i++)
-		rewind(procTable[i].tracefp);
+// access를 최대 max개까지 한 번에 읽는다. 읽은 개수를 돌려준다
+int readTraceBatch(struct traceFile *trace, uint64_t *addrs, char *rws, int max) {
+	int n = 0;
+	while(n < max && readTrace(trace, &addrs[n], &rws[n]) != EOF)
+		n++;
+	return n;
 }
 
-int main(int argc, char *argv[]) {	// argc : main함수에 전달 된 인자의 개수. 인자를 아무것도 주지 않고 main함수 호출 시 argc=1 (호출 이름 때문.)
-									// argv : main함수로 전달 되는 데이터. 문자열의 형태를 띈다.
-	int i;
+// 압축 trace를 record 번호 n부터 읽도록 옮긴다. index에서 n이 들어 있는 block을 찾아 그 block만 decode한다
+void seekTrace(struct traceFile *trace, uint64_t n) {
+	struct ctrace *ct = trace->ct;
+	uint64_t lo = 0, hi = ct->header.nblocks, mid;
 
-	if (argc < 5) {	//인자 잘못 넣었을 경우 출력.
-	     printf("Usage : %s [-s] firstLevelBits PhysicalMemorySizeBits TraceFileNames\n",argv[0]); exit(1);
+	while(hi - lo > 1) {
+		mid = (lo + hi) / 2;
+		if(ct->index[mid].firstRecord <= n)
+			lo = mid;
+		else
+			hi = mid;
 	}
+	ct->block = lo;
+	ct->len = ct->pos = 0;
+	trace->pos = n < ct->header.nrecords ? n : ct->header.nrecords;
+	if(trace->pos < ct->header.nrecords && loadCtraceBlock(trace))
+		ct->pos = (int)(trace->pos - ct->index[lo].firstRecord);
+}
 
-	// 사용할 변수들 생성 및 초기화.
-	if(!strcmp(argv[1],"-s")) { s_flag = 1; } // [-s] 인자 확인하여 s_flag 초기화.
-	numProcess =  argc - 4 - s_flag;	// 프로세스의 개수 초기화 (main함수가 받는 인자의 개수에서 traceFileName이 아닌 개수와 s_flag를 뺀다)
-	struct procEntry procTable[numProcess];	// 프로세스의 개수만큼 procEntry 생성
-	struct procEntry *procTableptr = procTable;
-	firstLevelBits = atoi(argv[s_flag + 2]);
-	phyMemSizeBits = atoi(argv[s_flag + 3]);
+void rewindTrace(struct traceFile *trace) {
+	trace->time = trace->nread = 0;
+	if(trace->format == TRACE_BINARY)
+		trace->pos = 0;
+	else if(trace->format == TRACE_COMPRESSED)
+		seekTrace(trace, 0);
+	else {
+		lseek(trace->fd, 0, SEEK_SET);
+		trace->bufLen = trace->bufPos = 0;
+		trace->buf[0] = '\0';
+		trace->eof = 0;
+	}
+}
 
-	if (phyMemSizeBits < PAGESIZEBITS) {
-		printf("PhysicalMemorySizeBits %d should be larger than PageSizeBits %d\n",phyMemSizeBits,PAGESIZEBITS); exit(1);
+void closeTrace(struct traceFile *trace) {
+	if(trace->format == TRACE_BINARY)
+		munmap(trace->map, trace->mapSize);
+	else if(trace->format == TRACE_COMPRESSED) {
+		close(trace->fd);
+		free(trace->ct->index);
+		free(trace->ct->stored);
+		free(trace->ct->raw);
+		free(trace->ct->addr);
+		free(trace->ct->time);
+		free(trace->ct->rw);
+		free(trace->ct);
 	}
-	if (VIRTUALADDRBITS - PAGESIZEBITS - firstLevelBits <= 0 ) {
-		printf("firstLevelBits %d is too Big for the 2nd level page system\n",firstLevelBits); exit(1);
+	else {
+		close(trace->fd);
+		free(trace->buf);
 	}
-	
-	// initialize procTable for memory simulations
-	for(i = 0; i < numProcess; i++) {
-		// opening a tracefile for the process
-		printf("process %d opening %s\n",i,argv[s_flag + 4 + i]);
+}
+
+// text trace를 binary trace 파일로 변환. 성공하면 0, 실패하면 -1
+int convertTrace(const char *textName, const char *binName) {
+	struct traceFile in;
+	FILE *out;
+	struct binTraceHeader header;
+	struct binTraceRecord record;
+	char tmpName[4096];
+	uint64_t addr;
+	char rw;
+	int err;
+
+	if(snprintf(tmpName, sizeof(tmpName), "%s.tmp", binName) >= (int)sizeof(tmpName))
+		return -1;
+	if(openTrace(&in, textName, 0) != 0)
+		return -1;
+	if((out = fopen(tmpName, "wb")) == NULL) {
+		closeTrace(&in);
+		return -1;
 	}
 
-	nFrame = (1<<(phyMemSizeBits-PAGESIZEBITS)); assert(nFrame>0);
-	struct framePage * phyMemFrames = (struct framePage *)malloc(sizeof(struct framePage) * nFrame);
-	initPhyMem(phyMemFrames, nFrame);
+	memcpy(header.magic, BINTRACE_MAGIC, 4);
+	header.version = BINTRACE_VERSION;
+	header.nrecords = 0;
+	fwrite(&header, sizeof(header), 1, out);	// nrecords는 마지막에 다시 쓴다
 
-	printf("\nNum of Frames %d Physical Memory Size %ld bytes\n",nFrame, (1L<<phyMemSizeBits));
+	memset(&record, 0, sizeof(record));
+	while(readTrace(&in, &addr, &rw) != EOF) {
+		record.addr = addr;
+		record.rwTime = (unsigned char)rw | in.time << 8;	// timestamp는 56bit까지
+		fwrite(&record, sizeof(record), 1, out);
+		header.nrecords++;
+	}
+	closeTrace(&in);
 
-	for(i = 0; i < numProcess; i++) {
-		// initialize procTable fields
-		procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-		strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-		procTable[i].pid = i;
-		procTable[i].ntraces = 0;
-		procTable[i].num2ndLevelPageTable = 0;
-		procTable[i].numIHTConflictAccess = 0;
-		procTable[i].numIHTNULLAccess = 0;
-		procTable[i].numIHTNonNULLAcess = 0;
-		procTable[i].numPageFault = 0;
-		procTable[i].numPageHit = 0;
-		procTable[i].firstLevelPageTable = NULL;
-		procTable[i].eof_valid = 0;
-		procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
+	rewind(out);
+	fwrite(&header, sizeof(header), 1, out);
+	err = ferror(out);
+	if(fclose(out) != 0 || err || rename(tmpName, binName) != 0) {
+		unlink(tmpName);
+		return -1;
 	}
+	return 0;
+}
 
-	if (*argv[s_flag + 1] == '0') {	// simType = 0, One-level page table system을 수행
-		printf("=============================================================\n");
-		printf("The One-Level Page Table with FIFO Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call oneLevelVMSim() with FIFO
-		oneLevelVMSim(procTableptr, phyMemFrames, 'F');
+// trace를 압축 trace 파일로 변환. zlib이면 block마다 zlib으로 한 번 더 압축한다. 성공하면 0, 실패하면 -1
+int compressTrace(const char *name, const char *outName, int zlib) {
+	struct traceFile in;
+	FILE *out;
+	struct ctraceHeader header;
+	struct ctraceBlock *index = NULL;
+	uint64_t *addrs, *times, inBytes, nalloc = 0;
+	char *rws, tmpName[4096];
+	unsigned char *raw, *stored;
+	size_t rawSize, storedBound;
+	struct stat st;
+	int n, err;
 
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
-		}
+#ifndef MEMSIM_ZLIB
+	if(zlib) {
+		printf("zlib blocks need a build with -DMEMSIM_ZLIB -lz\n");
+		return -1;
+	}
+#endif
+	if(snprintf(tmpName, sizeof(tmpName), "%s.tmp", outName) >= (int)sizeof(tmpName))
+		return -1;
+	if(openTrace(&in, name, 0) != 0)
+		return -1;
+	if((out = fopen(tmpName, "wb")) == NULL) {
+		closeTrace(&in);
+		return -1;
+	}
+	if(in.format == TRACE_BINARY)
+		inBytes = in.mapSize;
+	else
+		inBytes = fstat(in.fd, &st) == 0 ? (uint64_t)st.st_size : 0;
 
-		printf("=============================================================\n");
-		printf("The One-Level Page Table with LRU Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call oneLevelVMSim() with LRU
-		oneLevelVMSim(procTableptr, phyMemFrames, 'L');
+	storedBound = (size_t)CTRACE_BLOCK * CTRACE_MAXRECORD;
+#ifdef MEMSIM_ZLIB
+	storedBound = compressBound(storedBound);
+#endif
+	addrs = (uint64_t *)malloc(sizeof(uint64_t) * CTRACE_BLOCK);
+	times = (uint64_t *)malloc(sizeof(uint64_t) * CTRACE_BLOCK);
+	rws = (char *)malloc(CTRACE_BLOCK);
+	raw = (unsigned char *)malloc((size_t)CTRACE_BLOCK * CTRACE_MAXRECORD);
+	stored = (unsigned char *)malloc(storedBound);
 
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, CTRACE_MAGIC, 4);
+	header.version = CTRACE_VERSION;
+	header.flags = zlib ? CTRACE_ZLIB : 0;
+	header.blockRecords = CTRACE_BLOCK;
+	fwrite(&header, sizeof(header), 1, out);	// nrecords, nblocks, indexOffset은 마지막에 다시 쓴다
+
+	for(;;) {
+		for(n = 0; n < CTRACE_BLOCK && readTrace(&in, &addrs[n], &rws[n]) != EOF; n++)
+			times[n] = in.time;
+		if(n == 0)
+			break;
+		if(header.nblocks == nalloc) {
+			nalloc = nalloc ? nalloc * 2 : 64;
+			index = (struct ctraceBlock *)realloc(index, sizeof(struct ctraceBlock) * nalloc);
+		}
+		rawSize = encodeCtraceBlock(addrs, rws, times, n, header.nrecords, raw);
+		index[header.nblocks].offset = ftello(out);
+		index[header.nblocks].firstRecord = header.nrecords;
+		index[header.nblocks].rawSize = rawSize;
+		index[header.nblocks].nrecords = n;
+		index[header.nblocks].reserved = 0;
+		if(zlib) {
+#ifdef MEMSIM_ZLIB
+			uLongf storedLen = storedBound;
+			compress2(stored, &storedLen, raw, rawSize, Z_DEFAULT_COMPRESSION);
+			index[header.nblocks].storedSize = storedLen;
+			fwrite(stored, 1, storedLen, out);
+#endif
 		}
+		else {
+			index[header.nblocks].storedSize = rawSize;
+			fwrite(raw, 1, rawSize, out);
+		}
+		header.nrecords += n;
+		header.nblocks++;
+		if(n < CTRACE_BLOCK)
+			break;
 	}
+	closeTrace(&in);
 
+	header.indexOffset = ftello(out);
+	fwrite(index, sizeof(struct ctraceBlock), header.nblocks, out);
+	rewind(out);
+	fwrite(&header, sizeof(header), 1, out);
+	printf("%s: %llu records in %llu blocks, %llu -> %llu bytes (%.2f bytes/record, x%.1f)\n", name,
+			(unsigned long long)header.nrecords, (unsigned long long)header.nblocks, (unsigned long long)inBytes,
+			(unsigned long long)(header.indexOffset + header.nblocks * sizeof(struct ctraceBlock)),
+			header.nrecords ? (double)header.indexOffset / header.nrecords : 0.0,
+			header.indexOffset ? (double)inBytes / header.indexOffset : 0.0);
 
+	free(index);
+	free(addrs);
+	free(times);
+	free(rws);
+	free(raw);
+	free(stored);
+	err = ferror(out);
+	if(fclose(out) != 0 || err || rename(tmpName, outName) != 0) {
+		unlink(tmpName);
+		return -1;
+	}
+	return 0;
+}
 
 
-	else if (*argv[s_flag + 1] == '1') {	// simType = 1, Two-level page table system을 수행
-		printf("=============================================================\n");
-		printf("The Two-Level Page Table Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call twoLevelVMSim()
-		twoLevelVMSim(procTableptr, phyMemFrames);
+// 64bit hash 섞기 (murmur3 finalizer)
+static inline uint64_t mix64(uint64_t x) {
+	x ^= x >> 33;
+	x *= 0xff51afd7ed558ccdULL;
+	x ^= x >> 33;
+	x *= 0xc4ceb9fe1a85ec53ULL;
+	x ^= x >> 33;
+	return x;
+}
 
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
-		}
-	}
-	
-	// initialize procTable for the simulation
-
-	else if (*argv[s_flag + 1] == '2') {	// simType = 2, Inverted page table system을 수행
-		printf("=============================================================\n");
-		printf("The Inverted Page Table Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call invertedPageVMsim()
-		invertedPageVMSim(procTableptr, phyMemFrames, nFrame);
+// uint64 key -> uint64 value hash (open addressing, linear probing). 삭제는 하지 않는다
+#define PAGEMAP_EMPTY UINT64_MAX
 
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
-		}
-	}
-
-	// initialize procTable for the simulation
-
-	else {	// simType > 3, 모두 수행	
-		printf("=============================================================\n");
-		printf("The One-Level Page Table with FIFO Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call oneLevelVMSim() with FIFO
-		oneLevelVMSim(procTableptr, phyMemFrames, 'F');
-		
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
-		}
+struct pageMap {
+	uint64_t *keys, *values;
+	uint64_t size, count;		// size는 2의 거듭제곱
+};
 
-		printf("=============================================================\n");
-		printf("The One-Level Page Table with LRU Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call oneLevelVMSim() with LRU
-		oneLevelVMSim(procTableptr, phyMemFrames, 'L');
-		
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
-		}
+void pageMapInit(struct pageMap *m, uint64_t size) {
+	uint64_t i;
+	for(m->size = 16; m->size < size; m->size *= 2)
+		;
+	m->keys = (uint64_t *)malloc(sizeof(uint64_t) * m->size);
+	m->values = (uint64_t *)malloc(sizeof(uint64_t) * m->size);
+	for(i = 0; i < m->size; i++)
+		m->keys[i] = PAGEMAP_EMPTY;
+	m->count = 0;
+}
 
-		printf("=============================================================\n");
-		printf("The Two-Level Page Table Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call twoLevelVMSim()
-		twoLevelVMSim(procTableptr, phyMemFrames);
+void pageMapFree(struct pageMap *m) {
+	free(m->keys);
+	free(m->values);
+}
 
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
+static inline uint64_t *pageMapGet(struct pageMap *m, uint64_t key) {
+	uint64_t slot = mix64(key) & (m->size - 1);
+	while(m->keys[slot] != PAGEMAP_EMPTY) {
+		if(m->keys[slot] == key)
+			return &m->values[slot];
+		slot = (slot + 1) & (m->size - 1);
+	}
+	return NULL;
+}
+
+// key의 value 위치. 없으면 value를 init으로 넣는다. *inserted에 새로 넣었는지 돌려준다
+uint64_t *pageMapPut(struct pageMap *m, uint64_t key, uint64_t init, int *inserted) {
+	uint64_t slot, i;
+
+	if((m->count + 1) * 2 > m->size) {	// 반 이상 차면 두 배로
+		struct pageMap old = *m;
+		pageMapInit(m, old.size * 2);
+		for(i = 0; i < old.size; i++)
+			if(old.keys[i] != PAGEMAP_EMPTY)
+				*pageMapPut(m, old.keys[i], old.values[i], NULL) = old.values[i];
+		pageMapFree(&old);
+	}
+
+	slot = mix64(key) & (m->size - 1);
+	while(m->keys[slot] != PAGEMAP_EMPTY) {
+		if(m->keys[slot] == key) {
+			if(inserted)
+				*inserted = 0;
+			return &m->values[slot];
 		}
+		slot = (slot + 1) & (m->size - 1);
+	}
+	m->keys[slot] = key;
+	m->values[slot] = init;
+	m->count++;
+	if(inserted)
+		*inserted = 1;
+	return &m->values[slot];
+}
 
-		printf("=============================================================\n");
-		printf("The Inverted Page Table Memory Simulation Starts .....\n");
-		printf("=============================================================\n");
-		// call invertedPageVMsim()
-		invertedPageVMSim(procTableptr, phyMemFrames, nFrame);
+#define ARENA_CHUNK (1 << 22)	// arena가 한 번에 확보하는 크기 (bytes)
 
-		initPhyMem(phyMemFrames, nFrame);
-		// initialize procTable for the simulation
-		for(i = 0; i < numProcess; i++) {
-			// initialize procTable fields
-			procTable[i].traceName = (char *)malloc(strlen(argv[s_flag + 4 + i]) + 1);
-			strcpy(procTable[i].traceName, argv[s_flag + 4 + i]);
-			procTable[i].pid = i;
-			procTable[i].ntraces = 0;
-			procTable[i].num2ndLevelPageTable = 0;
-			procTable[i].numIHTConflictAccess = 0;
-			procTable[i].numIHTNULLAccess = 0;
-			procTable[i].numIHTNonNULLAcess = 0;
-			procTable[i].numPageFault = 0;
-			procTable[i].numPageHit = 0;
-			procTable[i].firstLevelPageTable = NULL;
-			procTable[i].eof_valid = 0;
-			procTable[i].tracefp = fopen(argv[s_flag + 4 + i], "r");
+// 해제하지 않는 작은 할당들을 큰 chunk에서 잘라서 준다. 시뮬레이션이 끝나면 한 번에 해제한다
+struct arena {
+	char **chunks;
+	int nchunks, maxChunks;
+	size_t used;				// 마지막 chunk에서 쓴 bytes
+	size_t chunkSize;			// 마지막 chunk의 크기
+	uint64_t bytes;				// 지금까지 할당한 bytes
+};
+
+void arenaInit(struct arena *a) {
+	a->chunks = NULL;
+	a->nchunks = a->maxChunks = 0;
+	a->used = a->chunkSize = 0;
+	a->bytes = 0;
+}
+
+// 0으로 채워진 size bytes
+void *arenaAlloc(struct arena *a, size_t size) {
+	void *p;
+
+	size = (size + 15) & ~(size_t)15;
+	if(a->nchunks == 0 || a->used + size > a->chunkSize) {
+		if(a->nchunks == a->maxChunks) {
+			a->maxChunks = a->maxChunks ? a->maxChunks * 2 : 16;
+			a->chunks = (char **)realloc(a->chunks, sizeof(char *) * a->maxChunks);
 		}
+		a->chunkSize = size > ARENA_CHUNK ? size : ARENA_CHUNK;
+		a->chunks[a->nchunks++] = (char *)calloc(1, a->chunkSize);	// 큰 calloc은 mmap이므로 건드린 page만 메모리를 쓴다
+		a->used = 0;
 	}
+	p = a->chunks[a->nchunks - 1] + a->used;
+	a->used += size;
+	a->bytes += size;
+	return p;
+}
+
+void arenaFree(struct arena *a) {
+	int i;
+	for(i = 0; i < a->nchunks; i++)
+		free(a->chunks[i]);
+	free(a->chunks);
+	arenaInit(a);
+}
+
+// -s 출력 sink. access마다 printf하지 않고 큰 buffer에 직접 formatting해서 모아 쓴다
+#define SINK_BUFSIZE (1 << 20)
+#define SINK_MAXRECORD 160		// text 한 줄의 최대 길이
+
+#define XLATE_MAGIC "MSXL"		// binary translation record 파일. header 뒤에 record가 이어진다
+#define XLATE_VERSION 1
+#define XLATE_FAULT 1			// page fault
+#define XLATE_SLOWTIER 2		// slow tier에서 찾음 (-M)
+#define XLATE_PROMOTED 4		// slow tier에서 fast tier로 올림
+
+enum sinkKind { SINK_ONELEVEL, SINK_TWOLEVEL, SINK_INVERTED, SINK_RADIX, SINK_SLOWTIER };
+static const char *const sinkPrefix[] = { "One-Level", "Two-Level", "IHT", "Radix", "Slow-Tier" };
+
+struct xlateHeader {
+	char magic[4];				// "MSXL"
+	uint32_t version;			// XLATE_VERSION
+	uint32_t recordSize;		// sizeof(struct xlateRecord)
+	uint32_t reserved;
+};
+
+struct xlateRecord {
+	uint64_t vaddr, paddr;
+	uint64_t traceNumber;		// 프로세스 안에서 1부터
+	int32_t pid;
+	uint16_t flags;				// XLATE_FAULT, XLATE_SLOWTIER, XLATE_PROMOTED
+	uint8_t kind;				// enum sinkKind
+	uint8_t reserved;
+};
+
+struct outputSink {
+	FILE *fp;
+	char *buf;
+	size_t len;
+	char format;
+	int faultsOnly, pid;
+};
+
+struct outputSink *sinkOpen(void) {
+	struct outputSink *out = (struct outputSink *)malloc(sizeof(struct outputSink));
+
+	out->fp = sinkConf.fp != NULL ? sinkConf.fp : stdout;
+	out->buf = (char *)malloc(SINK_BUFSIZE);
+	out->len = 0;
+	out->format = sinkConf.format;
+	out->faultsOnly = sinkConf.faultsOnly;
+	out->pid = sinkConf.pid;
+	return out;
+}
+
+// 모은 출력을 내보낸다. report를 출력하기 전에 불러야 순서가 섞이지 않는다
+void sinkFlush(struct outputSink *out) {
+	if(out->len > 0)
+		fwrite(out->buf, 1, out->len, out->fp);
+	out->len = 0;
+}
+
+void sinkClose(struct outputSink *out) {
+	sinkFlush(out);
+	fflush(out->fp);
+	free(out->buf);
+	free(out);
+}
 
+static inline char *sinkDec(char *p, uint64_t v) {
+	char tmp[20];
+	int n = 0;
+
+	do
+		tmp[n++] = '0' + v % 10;
+	while((v /= 10) != 0);
+	while(n > 0)
+		*p++ = tmp[--n];
+	return p;
+}
+
+static inline char *sinkHex(char *p, uint64_t v) {
+	int n = v ? (67 - __builtin_clzll(v)) / 4 : 1;	// 자리 수
+
+	p += n;
+	do
+		*--p = "0123456789abcdef"[v & 15];
+	while((v >>= 4) != 0);
+	return p + n;
+}
+
+static inline char *sinkStr(char *p, const char *s) {
+	while(*s)
+		*p++ = *s++;
+	return p;
+}
+
+// translation 하나. text는 원래의 printf와 같은 줄을 쓴다
+static void sinkTranslation(struct outputSink *out, enum sinkKind kind, int pid, long long traceNumber,
+		uint64_t vaddr, uint64_t paddr, int flags) {
+	struct xlateRecord *rec;
+	char *p;
+
+	if((out->faultsOnly && !(flags & XLATE_FAULT)) || (out->pid >= 0 && pid != out->pid))
+		return;
+	if(out->len > SINK_BUFSIZE - SINK_MAXRECORD)
+		sinkFlush(out);
+	if(out->format == 'b') {
+		rec = (struct xlateRecord *)(out->buf + out->len);
+		rec->vaddr = vaddr;
+		rec->paddr = paddr;
+		rec->traceNumber = traceNumber;
+		rec->pid = pid;
+		rec->flags = flags;
+		rec->kind = kind;
+		rec->reserved = 0;
+		out->len += sizeof(struct xlateRecord);
+		return;
+	}
+	p = sinkStr(out->buf + out->len, sinkPrefix[kind]);
+	p = sinkStr(p, " procID ");
+	p = sinkDec(p, pid);
+	p = sinkStr(p, " traceNumber ");
+	p = sinkDec(p, traceNumber);
+	p = sinkStr(p, " virtual addr ");
+	p = sinkHex(p, vaddr);
+	p = sinkStr(p, " physical addr ");
+	p = sinkHex(p, paddr);
+	if(flags & XLATE_PROMOTED)
+		p = sinkStr(p, " promoted");
+	*p++ = '\n';
+	out->len = p - out->buf;
+}
+
+struct vmSim;
+
+// page replacement policy. 세 가지 page table 구성이 모두 같은 interface를 쓴다.
+// 빈 frame이 남아있는 동안은 policy를 거치지 않고 frame 번호 순서대로 쓰고, 그 다음부터 victim()이 내보낼 frame을 고른다.
+struct replPolicyOps {
+	char code;					// command line에서 쓰는 문자
+	const char *name;
+	void (*init)(struct vmSim *sim);
+	void (*hit)(struct vmSim *sim, int frame);				// 매핑된 page가 다시 access됨
+	int (*victim)(struct vmSim *sim, int pid, uint64_t vpn);	// (pid, vpn)을 올리기 위해 비울 frame
+	void (*fill)(struct vmSim *sim, int frame, int pid, uint64_t vpn);	// frame에 (pid, vpn)이 매핑됨
+	void (*free)(struct vmSim *sim);
+	void (*report)(struct vmSim *sim);	// policy별 추가 결과 출력 (없으면 NULL)
+};
+
+// 시뮬레이터 instance. 각 instance는 자기 frame list와 procTable을 가지므로 서로 독립적으로 돌릴 수 있다
+struct vmSim {
+	char type;					// '0' one-level, '1' two-level, '2' inverted
+	char title[96];
+	const struct replPolicyOps *policy;
+	void *policyState;			// policy별 상태 (CLOCK, ARC 등)
+	struct procEntry *procTable;	// 이 instance의 프로세스별 page table과 통계
+	int nProc;					// procTable의 프로세스 수
+	int lastPid;				// 마지막으로 access한 프로세스 (context switch를 센다)
+	struct frameTable frames;
+	uint32_t oldestFrame;		// FIFO/LRU list에서 가장 오래된 frame
+	int nLinkedFrame;			// FIFO/LRU list에 들어간 frame 수
+	int nFrame;
+	int nUsedFrame;				// 한 번이라도 매핑된 frame 수. 이 수보다 큰 번호의 frame은 비어있다
+	int firstLevelBits, twoLevelBits;
+	int firstLevelPageTableSize, twoLevelPageTableSize;
+	struct invertedPageTableEntry *invertedPageTable;	// chained: bucket head들
+	struct invertedPageTableEntry *iptNodes;	// chained: frame마다 하나씩 미리 할당한 entry
+	struct iptSlot *iptSlots;	// open addressing table
+	int iptSize;
+	char iptHash;
+	struct arena tableArena;	// one-level PTE chunk와 N-level radix table들
+	struct tlbState *tlb;		// NULL이면 TLB 없음
+	int pageBits;				// page offset bit 수
+	void (*access)(struct vmSim *sim, int i, uint64_t addr, char rw);	// pageBits에 맞춰 compile된 kernel
+	struct pageMap *thp;		// THP: pageKey(pid, region) -> resident 수 | THP_HUGE. NULL이면 THP 없음
+	struct prefetchState *prefetch;	// NULL이면 prefetch 없음
+	struct tierState *tier;		// NULL이면 slow tier 없음 (fast tier에서 내보낸 page는 disk로)
+	struct cacheState *cache;	// NULL이면 cache 없음
+	int colors;					// page coloring의 color 수. 0이면 coloring 없음
+	struct outputSink *out;		// access마다 translation을 출력 (-s). NULL이면 출력 없음
+};
+
+// frame table 할당. 배열은 frame을 처음 쓸 때 채우므로 큰 physical memory도 쓴 만큼만 메모리를 차지한다
+void initPhyMem(struct vmSim *sim) {
+	struct frameTable *frames = &sim->frames;
+	size_t nFrame = sim->nFrame;
+
+	frames->pid = (int *)malloc(sizeof(int) * nFrame);
+	frames->vpn = (int64_t *)malloc(sizeof(int64_t) * nFrame);
+	frames->dirty = (unsigned char *)malloc(nFrame);
+	frames->pte = sim->type == '4' ? (uint64_t **)malloc(sizeof(uint64_t *) * nFrame) : NULL;
+	frames->link = (struct frameLink *)malloc(sizeof(struct frameLink) * nFrame);
+	frames->filled = sim->thp != NULL || sim->prefetch != NULL ? (unsigned char *)malloc(nFrame) : NULL;
+
+	sim->oldestFrame = 0;
+	sim->nLinkedFrame = 0;
+	sim->nUsedFrame = 0;
+}
+
+void freePhyMem(struct vmSim *sim) {
+	free(sim->frames.pid);
+	free(sim->frames.vpn);
+	free(sim->frames.dirty);
+	free(sim->frames.pte);
+	free(sim->frames.link);
+	free(sim->frames.filled);
+}
+
+// frame을 list의 가장 최근 위치(oldestFrame 바로 앞)로 옮긴다
+static inline void moveToMRU(struct vmSim *sim, uint32_t frame) {
+	struct frameLink *link = sim->frames.link;
+	uint32_t oldest = sim->oldestFrame;
+
+	if(oldest == frame)
+		sim->oldestFrame = link[frame].next;
+
+	else {
+		link[link[frame].prev].next = link[frame].next;
+		link[link[frame].next].prev = link[frame].prev;
+		link[frame].next = oldest;
+		link[frame].prev = link[oldest].prev;
+		link[link[oldest].prev].next = frame;
+		link[oldest].prev = frame;
+	}
+}
+
+// 새로 매핑된 frame을 list의 가장 최근 위치에 둔다. 처음 쓰는 frame이면 list에 넣는다
+static inline void listAppend(struct vmSim *sim, uint32_t frame) {
+	struct frameLink *link = sim->frames.link;
+	uint32_t oldest = sim->oldestFrame;
+
+	if((int)frame != sim->nLinkedFrame) {
+		moveToMRU(sim, frame);
+		return;
+	}
+	if(sim->nLinkedFrame++ == 0) {
+		link[frame].prev = link[frame].next = frame;
+		sim->oldestFrame = frame;
+		return;
+	}
+	link[frame].next = oldest;
+	link[frame].prev = link[oldest].prev;
+	link[link[oldest].prev].next = frame;
+	link[oldest].prev = frame;
+}
+
+#define PAGEKEY_PIDSHIFT 48		// vpn은 48bit (virtual address 60bit)까지
+
+static inline uint64_t pageKey(int pid, uint64_t vpn) {
+	return ((uint64_t)pid << PAGEKEY_PIDSHIFT) | vpn;
+}
+
+// simType의 시뮬레이터가 보는 VPN. '4'만 64bit 주소를 쓰고 나머지는 하위 32bit만 쓴다 (vmSimAccess와 같게)
+static inline uint64_t simPage(char type, uint64_t addr) {
+	return (type == '4' ? addr : (uint32_t)addr) >> pageSizeBits;
+}
+
+// FIFO, LRU: frame의 원형 list. oldestFrame이 victim이고 새 page는 oldestFrame 바로 앞에 들어간다
+static void listInit(struct vmSim *sim) { (void)sim; }
+static void listFree(struct vmSim *sim) { (void)sim; }
+static void fifoHit(struct vmSim *sim, int frame) { (void)sim; (void)frame; }
+static void lruHit(struct vmSim *sim, int frame) { moveToMRU(sim, frame); }
+
+static int colorVictim(struct vmSim *sim, int pid, uint64_t vpn);
+
+static int listVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	if(sim->colors > 1)
+		return colorVictim(sim, pid, vpn);
+	return sim->oldestFrame;
+}
+
+static void listFill(struct vmSim *sim, int frame, int pid, uint64_t vpn) {
+	(void)pid; (void)vpn;
+	listAppend(sim, frame);
+}
+
+// Second chance: FIFO list에 reference bit. victim 후보가 referenced이면 bit을 지우고 list 끝으로 보낸다
+static void refBitInit(struct vmSim *sim) {
+	sim->policyState = calloc(sim->nFrame, 1);
+}
+
+static void refBitFree(struct vmSim *sim) {
+	free(sim->policyState);
+}
+
+static void refBitHit(struct vmSim *sim, int frame) {
+	((unsigned char *)sim->policyState)[frame] = 1;
+}
+
+static int secondChanceVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	unsigned char *ref = (unsigned char *)sim->policyState;
+	(void)pid; (void)vpn;
+	while(ref[sim->oldestFrame]) {
+		ref[sim->oldestFrame] = 0;
+		sim->oldestFrame = sim->frames.link[sim->oldestFrame].next;	// 원형 list이므로 oldestFrame을 넘기면 list 끝으로 간 것과 같다
+	}
+	return sim->oldestFrame;
+}
+
+static void secondChanceFill(struct vmSim *sim, int frame, int pid, uint64_t vpn) {
+	(void)pid; (void)vpn;
+	((unsigned char *)sim->policyState)[frame] = 1;
+	listAppend(sim, frame);
+}
+
+// CLOCK: frame 배열 위를 도는 hand와 reference bit. hit 때 pointer를 옮기지 않는다.
+// victim은 second chance와 같지만 list 대신 frame 번호만 움직인다
+struct clockState {
+	int hand;
+	unsigned char *ref;
+};
+
+static void clockInit(struct vmSim *sim) {
+	struct clockState *clock = (struct clockState *)malloc(sizeof(struct clockState));
+	clock->hand = 0;
+	clock->ref = (unsigned char *)calloc(sim->nFrame, 1);
+	sim->policyState = clock;
+}
+
+static void clockFree(struct vmSim *sim) {
+	struct clockState *clock = (struct clockState *)sim->policyState;
+	free(clock->ref);
+	free(clock);
+}
+
+static void clockHit(struct vmSim *sim, int frame) {
+	((struct clockState *)sim->policyState)->ref[frame] = 1;
+}
+
+static int clockVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	struct clockState *clock = (struct clockState *)sim->policyState;
+	int victim;
+	(void)pid; (void)vpn;
+	while(clock->ref[clock->hand]) {
+		clock->ref[clock->hand] = 0;
+		clock->hand = (clock->hand + 1 == sim->nFrame) ? 0 : clock->hand + 1;
+	}
+	victim = clock->hand;
+	clock->hand = (clock->hand + 1 == sim->nFrame) ? 0 : clock->hand + 1;
+	return victim;
+}
+
+static void clockFill(struct vmSim *sim, int frame, int pid, uint64_t vpn) {
+	(void)pid; (void)vpn;
+	((struct clockState *)sim->policyState)->ref[frame] = 1;
+}
+
+// 배열 index로 연결한 doubly linked list. head가 가장 오래된 쪽
+struct idxList {
+	int head, tail, size;
+};
+
+static inline void idxListInit(struct idxList *l) {
+	l->head = l->tail = -1;
+	l->size = 0;
+}
+
+static inline void idxListRemove(struct idxList *l, int *prev, int *next, int i) {
+	if(prev[i] != -1) next[prev[i]] = next[i]; else l->head = next[i];
+	if(next[i] != -1) prev[next[i]] = prev[i]; else l->tail = prev[i];
+	l->size--;
+}
+
+static inline void idxListPushTail(struct idxList *l, int *prev, int *next, int i) {
+	prev[i] = l->tail;
+	next[i] = -1;
+	if(l->tail != -1) next[l->tail] = i; else l->head = i;
+	l->tail = i;
+	l->size++;
+}
+
+// ARC (Megiddo & Modha). T1은 한 번, T2는 두 번 이상 access된 page, B1/B2는 T1/T2에서 쫓겨난 page의 ghost.
+// ghost hit에 따라 T1의 목표 크기 p를 조절한다
+struct arcState {
+	int c;						// cache 크기 (frame 수)
+	int p;						// T1의 목표 크기
+	int *prev, *next;			// frame별 T1/T2 list link
+	char *where;				// frame이 들어있는 list (1 = T1, 2 = T2)
+	struct idxList t[3];		// t[1] = T1, t[2] = T2
+	uint64_t *ghostKey;			// ghost node pool (c + 1개)
+	int *ghostPrev, *ghostNext, *ghostHashNext;
+	char *ghostWhere;			// ghost가 들어있는 list (1 = B1, 2 = B2)
+	struct idxList b[3];		// b[1] = B1, b[2] = B2
+	int *bucket;				// key -> ghost node hash
+	int nbucket;
+	int freeGhost;				// 빈 ghost node list (ghostNext로 연결)
+	int fillList;				// victim()이 정한, 다음 fill이 들어갈 list
+};
+
+static void arcInit(struct vmSim *sim) {
+	struct arcState *arc = (struct arcState *)malloc(sizeof(struct arcState));
+	int i, n = sim->nFrame + 1;
+
+	arc->c = sim->nFrame;
+	arc->p = 0;
+	arc->prev = (int *)malloc(sizeof(int) * sim->nFrame);
+	arc->next = (int *)malloc(sizeof(int) * sim->nFrame);
+	arc->where = (char *)calloc(sim->nFrame, 1);
+	idxListInit(&arc->t[1]);
+	idxListInit(&arc->t[2]);
+	arc->ghostKey = (uint64_t *)malloc(sizeof(uint64_t) * n);
+	arc->ghostPrev = (int *)malloc(sizeof(int) * n);
+	arc->ghostNext = (int *)malloc(sizeof(int) * n);
+	arc->ghostHashNext = (int *)malloc(sizeof(int) * n);
+	arc->ghostWhere = (char *)calloc(n, 1);
+	idxListInit(&arc->b[1]);
+	idxListInit(&arc->b[2]);
+	for(arc->nbucket = 1; arc->nbucket < 2 * n; arc->nbucket *= 2)
+		;
+	arc->bucket = (int *)malloc(sizeof(int) * arc->nbucket);
+	for(i = 0; i < arc->nbucket; i++)
+		arc->bucket[i] = -1;
+	for(i = 0; i < n; i++)
+		arc->ghostNext[i] = (i + 1 < n) ? i + 1 : -1;
+	arc->freeGhost = 0;
+	arc->fillList = 1;
+	sim->policyState = arc;
+}
+
+static void arcFree(struct vmSim *sim) {
+	struct arcState *arc = (struct arcState *)sim->policyState;
+	free(arc->prev);
+	free(arc->next);
+	free(arc->where);
+	free(arc->ghostKey);
+	free(arc->ghostPrev);
+	free(arc->ghostNext);
+	free(arc->ghostHashNext);
+	free(arc->ghostWhere);
+	free(arc->bucket);
+	free(arc);
+}
+
+static int arcGhostFind(struct arcState *arc, uint64_t key) {
+	int g;
+	for(g = arc->bucket[mix64(key) & (arc->nbucket - 1)]; g != -1; g = arc->ghostHashNext[g])
+		if(arc->ghostKey[g] == key)
+			return g;
+	return -1;
+}
+
+static void arcGhostDelete(struct arcState *arc, int g) {
+	int *link = &arc->bucket[mix64(arc->ghostKey[g]) & (arc->nbucket - 1)];
+
+	while(*link != g)
+		link = &arc->ghostHashNext[*link];
+	*link = arc->ghostHashNext[g];
+	idxListRemove(&arc->b[(int)arc->ghostWhere[g]], arc->ghostPrev, arc->ghostNext, g);
+	arc->ghostWhere[g] = 0;
+	arc->ghostNext[g] = arc->freeGhost;
+	arc->freeGhost = g;
+}
+
+static void arcGhostAdd(struct arcState *arc, int list, uint64_t key) {
+	int g = arc->freeGhost;
+	int h = mix64(key) & (arc->nbucket - 1);
+
+	arc->freeGhost = arc->ghostNext[g];
+	arc->ghostKey[g] = key;
+	arc->ghostWhere[g] = list;
+	arc->ghostHashNext[g] = arc->bucket[h];
+	arc->bucket[h] = g;
+	idxListPushTail(&arc->b[list], arc->ghostPrev, arc->ghostNext, g);
+}
+
+// T1 또는 T2의 LRU page를 내보내고 그 key를 B1 또는 B2의 ghost로 남긴다
+static int arcReplace(struct vmSim *sim, struct arcState *arc, int inB2) {
+	int list, victim;
+
+	if(arc->t[1].size >= 1 && (arc->t[1].size > arc->p || (inB2 && arc->t[1].size == arc->p) || arc->t[2].size == 0))
+		list = 1;
+	else
+		list = 2;
+	victim = arc->t[list].head;
+	idxListRemove(&arc->t[list], arc->prev, arc->next, victim);
+	arc->where[victim] = 0;
+	arcGhostAdd(arc, list, pageKey(sim->frames.pid[victim], sim->frames.vpn[victim]));
+	return victim;
+}
+
+static void arcHit(struct vmSim *sim, int frame) {
+	struct arcState *arc = (struct arcState *)sim->policyState;
+	idxListRemove(&arc->t[(int)arc->where[frame]], arc->prev, arc->next, frame);
+	arc->where[frame] = 2;
+	idxListPushTail(&arc->t[2], arc->prev, arc->next, frame);
+}
+
+static int arcVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	struct arcState *arc = (struct arcState *)sim->policyState;
+	int g = arcGhostFind(arc, pageKey(pid, vpn));
+	int victim, delta;
+
+	if(g != -1 && arc->ghostWhere[g] == 1) {	// B1 hit: T1을 늘린다
+		delta = arc->b[2].size > arc->b[1].size ? arc->b[2].size / arc->b[1].size : 1;
+		arc->p = (arc->p + delta < arc->c) ? arc->p + delta : arc->c;
+		victim = arcReplace(sim, arc, 0);
+		arcGhostDelete(arc, g);
+		arc->fillList = 2;
+	}
+	else if(g != -1) {							// B2 hit: T1을 줄인다
+		delta = arc->b[1].size > arc->b[2].size ? arc->b[1].size / arc->b[2].size : 1;
+		arc->p = (arc->p - delta > 0) ? arc->p - delta : 0;
+		victim = arcReplace(sim, arc, 1);
+		arcGhostDelete(arc, g);
+		arc->fillList = 2;
+	}
+	else {										// 처음 보는 page
+		if(arc->t[1].size + arc->b[1].size == arc->c) {
+			if(arc->t[1].size < arc->c) {
+				arcGhostDelete(arc, arc->b[1].head);
+				victim = arcReplace(sim, arc, 0);
+			}
+			else {	// B1이 비어있으면 T1의 LRU page를 ghost 없이 내보낸다
+				victim = arc->t[1].head;
+				idxListRemove(&arc->t[1], arc->prev, arc->next, victim);
+				arc->where[victim] = 0;
+			}
+		}
+		else {
+			if(arc->t[1].size + arc->t[2].size + arc->b[1].size + arc->b[2].size == 2 * arc->c)
+				arcGhostDelete(arc, arc->b[2].head);
+			victim = arcReplace(sim, arc, 0);
+		}
+		arc->fillList = 1;
+	}
+	return victim;
+}
+
+static void arcFill(struct vmSim *sim, int frame, int pid, uint64_t vpn) {
+	struct arcState *arc = (struct arcState *)sim->policyState;
+	(void)pid; (void)vpn;
+	arc->where[frame] = arc->fillList;
+	idxListPushTail(&arc->t[(int)arc->fillList], arc->prev, arc->next, frame);
+	arc->fillList = 1;	// 빈 frame을 채울 때는 victim()을 거치지 않으므로 T1
+}
+
+// OPT (Belady): 다음 access가 가장 먼 page를 내보낸다. 미리 만든 next-use index 파일에서
+// access마다 "이 page가 다음에 access되는 시점"을 순서대로 읽는다 (buildNextUseIndex 참고)
+#define OPT_NEVER UINT64_MAX	// 다시 access되지 않음
+#define OPT_READBUF 65536
+
+char optIndexName[4096] = "";	// next-use index 파일
+
+struct optState {
+	FILE *index;
+	uint64_t buf[OPT_READBUF];	// index 파일 read buffer
+	int bufLen, bufPos;
+	uint64_t *nextUse;			// frame별 다음 access 시점
+	int *heap, *pos;			// nextUse 최대 heap과 frame의 heap 내 위치
+	int heapSize;
+};
+
+static uint64_t optNextUse(struct optState *opt) {
+	if(opt->bufPos == opt->bufLen) {
+		opt->bufLen = fread(opt->buf, sizeof(uint64_t), OPT_READBUF, opt->index);
+		opt->bufPos = 0;
+		if(opt->bufLen == 0) {
+			printf("OPT next-use index is shorter than the trace\n"); exit(1);
+		}
+	}
+	return opt->buf[opt->bufPos++];
+}
+
+static void optSwap(struct optState *opt, int a, int b) {
+	int t = opt->heap[a];
+	opt->heap[a] = opt->heap[b];
+	opt->heap[b] = t;
+	opt->pos[opt->heap[a]] = a;
+	opt->pos[opt->heap[b]] = b;
+}
+
+// heap의 i번째 frame의 nextUse가 바뀌었을 때 위치를 바로잡는다
+static void optFix(struct optState *opt, int i) {
+	int child;
+
+	while(i > 0 && opt->nextUse[opt->heap[(i - 1) / 2]] < opt->nextUse[opt->heap[i]]) {
+		optSwap(opt, i, (i - 1) / 2);
+		i = (i - 1) / 2;
+	}
+	for(;;) {
+		child = 2 * i + 1;
+		if(child >= opt->heapSize)
+			break;
+		if(child + 1 < opt->heapSize && opt->nextUse[opt->heap[child + 1]] > opt->nextUse[opt->heap[child]])
+			child++;
+		if(opt->nextUse[opt->heap[child]] <= opt->nextUse[opt->heap[i]])
+			break;
+		optSwap(opt, i, child);
+		i = child;
+	}
+}
+
+static void optInit(struct vmSim *sim) {
+	struct optState *opt = (struct optState *)malloc(sizeof(struct optState));
+
+	if(optIndexName[0] == '\0' || (opt->index = fopen(optIndexName, "rb")) == NULL) {
+		printf("OPT needs the next-use index built by buildNextUseIndex()\n"); exit(1);
+	}
+	opt->bufLen = opt->bufPos = 0;
+	opt->nextUse = (uint64_t *)malloc(sizeof(uint64_t) * sim->nFrame);
+	opt->heap = (int *)malloc(sizeof(int) * sim->nFrame);
+	opt->pos = (int *)malloc(sizeof(int) * sim->nFrame);
+	opt->heapSize = 0;
+	sim->policyState = opt;
+}
+
+static void optFree(struct vmSim *sim) {
+	struct optState *opt = (struct optState *)sim->policyState;
+	fclose(opt->index);
+	free(opt->nextUse);
+	free(opt->heap);
+	free(opt->pos);
+	free(opt);
+}
+
+static void optHit(struct vmSim *sim, int frame) {
+	struct optState *opt = (struct optState *)sim->policyState;
+	opt->nextUse[frame] = optNextUse(opt);
+	optFix(opt, opt->pos[frame]);
+}
+
+static int optVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	(void)pid; (void)vpn;
+	return ((struct optState *)sim->policyState)->heap[0];	// fill()에서 새 nextUse로 갱신된다
+}
+
+static void optFill(struct vmSim *sim, int frame, int pid, uint64_t vpn) {
+	struct optState *opt = (struct optState *)sim->policyState;
+	(void)pid; (void)vpn;
+	opt->nextUse[frame] = optNextUse(opt);
+	if(frame >= sim->nUsedFrame - 1 && opt->heapSize < sim->nUsedFrame) {	// 처음 쓰는 빈 frame
+		opt->heap[opt->heapSize] = frame;
+		opt->pos[frame] = opt->heapSize++;
+	}
+	optFix(opt, opt->pos[frame]);
+}
+
+static void unmapFrame(struct vmSim *sim, int frame);
+
+// Working set (Denning)과 PFF (page fault frequency) allocation. 두 policy 모두 프로세스마다 resident set의
+// 크기를 스스로 정하고, 그 안에서는 LRU로 교체한다. 시간은 프로세스별 virtual time (그 프로세스의 access 수).
+//  W: 최근 tau번의 access에서 참조한 page만 남기고 나머지는 바로 내보낸다
+//  P: fault 간격이 pffInterval보다 길면 직전 fault 이후 참조하지 않은 page들을 내보내고, 짧으면 resident set을 늘린다
+// 늘려야 하는데 빈 frame이 없으면 resident set이 가장 큰 다른 프로세스를 suspend(swap out)해서 frame을 모두 돌려받는다.
+// trace는 멈출 수 없으므로 suspend된 프로세스는 다음 access부터 다시 page를 올리면서(swap in) 계속 진행한다
+#define WS_NONE UINT32_MAX
+
+struct wsProc {
+	uint32_t oldest;			// resident page들의 LRU ring에서 가장 오래된 frame
+	int resident;				// resident set 크기
+	int maxResident;
+	uint64_t now;				// virtual time
+	uint64_t lastFault;			// 마지막 page fault의 virtual time
+	double residentSum;			// access마다의 resident set 크기의 합 (평균용)
+	long long numSuspend;		// suspend된 횟수
+	int *samples;				// allocConf.sample번의 access마다 기록한 resident set 크기
+	int nsamples, maxSamples;
+};
+
+struct wsState {
+	struct wsProc *proc;
+	uint64_t *lastRef;			// frame별 마지막 참조 시각 (그 frame 주인의 virtual time)
+	int *freeFrames;			// 내보내서 비어있는 frame들
+	int nFree;
+	long long numSuspend;
+};
+
+static void wsInit(struct vmSim *sim) {
+	struct wsState *ws = (struct wsState *)malloc(sizeof(struct wsState));
+	int i;
+
+	ws->proc = (struct wsProc *)calloc(sim->nProc, sizeof(struct wsProc));
+	for(i = 0; i < sim->nProc; i++)
+		ws->proc[i].oldest = WS_NONE;
+	ws->lastRef = (uint64_t *)malloc(sizeof(uint64_t) * sim->nFrame);
+	ws->freeFrames = (int *)malloc(sizeof(int) * sim->nFrame);
+	ws->nFree = 0;
+	ws->numSuspend = 0;
+	sim->policyState = ws;
+}
+
+static void wsFree(struct vmSim *sim) {
+	struct wsState *ws = (struct wsState *)sim->policyState;
+	int i;
+	for(i = 0; i < sim->nProc; i++)
+		free(ws->proc[i].samples);
+	free(ws->proc);
+	free(ws->lastRef);
+	free(ws->freeFrames);
+	free(ws);
+}
+
+// frame을 프로세스 ring의 MRU 위치(oldest 바로 앞)에 넣는다
+static void wsLink(struct vmSim *sim, struct wsProc *p, uint32_t frame) {
+	struct frameLink *link = sim->frames.link;
+
+	if(p->oldest == WS_NONE) {
+		link[frame].prev = link[frame].next = frame;
+		p->oldest = frame;
+	}
+	else {
+		link[frame].next = p->oldest;
+		link[frame].prev = link[p->oldest].prev;
+		link[link[p->oldest].prev].next = frame;
+		link[p->oldest].prev = frame;
+	}
+	p->resident++;
+}
+
+static void wsUnlink(struct vmSim *sim, struct wsProc *p, uint32_t frame) {
+	struct frameLink *link = sim->frames.link;
+
+	if(link[frame].next == frame)
+		p->oldest = WS_NONE;
+	else {
+		link[link[frame].prev].next = link[frame].next;
+		link[link[frame].next].prev = link[frame].prev;
+		if(p->oldest == frame)
+			p->oldest = link[frame].next;
+	}
+	p->resident--;
+}
+
+// resident page를 내보내고 frame을 빈 frame으로 돌려놓는다
+static void wsRelease(struct vmSim *sim, struct wsState *ws, uint32_t frame) {
+	wsUnlink(sim, &ws->proc[sim->frames.pid[frame]], frame);
+	unmapFrame(sim, frame);
+	sim->frames.vpn[frame] = -1;
+	ws->freeFrames[ws->nFree++] = frame;
+}
+
+// working set window를 벗어난 page들을 내보낸다. now는 지금 access의 virtual time
+static void wsTrim(struct vmSim *sim, struct wsState *ws, struct wsProc *p, uint64_t now) {
+	while(p->oldest != WS_NONE && ws->lastRef[p->oldest] + allocConf.tau <= now)
+		wsRelease(sim, ws, p->oldest);
+}
+
+// access 하나가 끝날 때마다 resident set 크기를 기록한다
+static void wsTick(struct wsProc *p) {
+	p->residentSum += p->resident;
+	if(p->resident > p->maxResident)
+		p->maxResident = p->resident;
+	if(p->now % allocConf.sample == 0) {
+		if(p->nsamples == p->maxSamples) {
+			p->maxSamples = p->maxSamples ? 2 * p->maxSamples : 64;
+			p->samples = (int *)realloc(p->samples, sizeof(int) * p->maxSamples);
+		}
+		p->samples[p->nsamples++] = p->resident;
+	}
+}
+
+static void wsHit(struct vmSim *sim, int frame) {
+	struct wsState *ws = (struct wsState *)sim->policyState;
+	struct wsProc *p = &ws->proc[sim->frames.pid[frame]];
+
+	p->now++;
+	ws->lastRef[frame] = p->now;
+	wsUnlink(sim, p, frame);
+	wsLink(sim, p, frame);
+	if(sim->policy->code == 'W')
+		wsTrim(sim, ws, p, p->now);
+	wsTick(p);
+}
+
+// 빈 frame이 없을 때 불린다. 늘릴 필요가 없으면 자기 LRU page를, 늘려야 하면 다른 프로세스를 suspend해서 frame을 얻는다
+static int wsVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	struct wsState *ws = (struct wsState *)sim->policyState;
+	struct wsProc *p = &ws->proc[pid];
+	uint32_t frame;
+	int i, big = -1;
+	(void)vpn;
+
+	if(sim->policy->code == 'W')
+		wsTrim(sim, ws, p, p->now + 1);
+	if(ws->nFree > 0)
+		return ws->freeFrames[--ws->nFree];
+
+	// PFF에서 fault 간격이 길면 resident set을 늘리지 않는다
+	if(sim->policy->code == 'P' && p->now + 1 - p->lastFault > allocConf.pffInterval && p->oldest != WS_NONE) {
+		frame = p->oldest;
+		wsUnlink(sim, p, frame);
+		return frame;
+	}
+
+	for(i = 0; i < sim->nProc; i++)
+		if(i != pid && ws->proc[i].resident > 0 && (big < 0 || ws->proc[i].resident > ws->proc[big].resident))
+			big = i;
+	if(big < 0) {	// 다른 프로세스가 frame을 갖고 있지 않으면 자기 안에서 교체
+		frame = p->oldest;
+		wsUnlink(sim, p, frame);
+		return frame;
+	}
+	ws->proc[big].numSuspend++;
+	ws->numSuspend++;
+	while(ws->proc[big].oldest != WS_NONE)
+		wsRelease(sim, ws, ws->proc[big].oldest);
+	return ws->freeFrames[--ws->nFree];
+}
+
+static void wsFill(struct vmSim *sim, int frame, int pid, uint64_t vpn) {
+	struct wsState *ws = (struct wsState *)sim->policyState;
+	struct wsProc *p = &ws->proc[pid];
+	uint32_t f, next;
+	int n;
+	(void)vpn;
+
+	p->now++;
+	if(sim->policy->code == 'W')
+		wsTrim(sim, ws, p, p->now);
+	else if(p->now - p->lastFault > allocConf.pffInterval) {
+		// 직전 fault 이후 참조하지 않은 page들을 내보낸다
+		for(f = p->oldest, n = p->resident; n > 0; f = next, n--) {
+			next = sim->frames.link[f].next;
+			if(ws->lastRef[f] <= p->lastFault)
+				wsRelease(sim, ws, f);
+		}
+	}
+	p->lastFault = p->now;
+	ws->lastRef[frame] = p->now;
+	wsLink(sim, p, frame);
+	wsTick(p);
+}
+
+static void wsReport(struct vmSim *sim) {
+	struct wsState *ws = (struct wsState *)sim->policyState;
+	struct wsProc *p;
+	int i, k;
+
+	for(i = 0; i < sim->nProc; i++) {
+		p = &ws->proc[i];
+		printf("Proc %d Resident set size avg %.1f max %d, %lld suspensions\n", i,
+				p->now ? p->residentSum / p->now : 0.0, p->maxResident, p->numSuspend);
+		printf("Proc %d Resident set size every %llu references:", i, (unsigned long long)allocConf.sample);
+		for(k = 0; k < p->nsamples; k++)
+			printf(" %d", p->samples[k]);
+		printf("\n");
+	}
+	if(sim->policy->code == 'W')
+		printf("Working set window %llu references, %lld suspensions\n", (unsigned long long)allocConf.tau, ws->numSuspend);
+	else
+		printf("PFF fault interval %llu references, %lld suspensions\n", (unsigned long long)allocConf.pffInterval, ws->numSuspend);
+}
+
+static const struct replPolicyOps replPolicies[] = {
+	{ 'F', "FIFO", listInit, fifoHit, listVictim, listFill, listFree, NULL },
+	{ 'L', "LRU", listInit, lruHit, listVictim, listFill, listFree, NULL },
+	{ 'S', "Second-Chance", refBitInit, refBitHit, secondChanceVictim, secondChanceFill, refBitFree, NULL },
+	{ 'C', "CLOCK", clockInit, clockHit, clockVictim, clockFill, clockFree, NULL },
+	{ 'A', "ARC", arcInit, arcHit, arcVictim, arcFill, arcFree, NULL },
+	{ 'O', "OPT", optInit, optHit, optVictim, optFill, optFree, NULL },
+	{ 'W', "Working-Set", wsInit, wsHit, wsVictim, wsFill, wsFree, wsReport },
+	{ 'P', "PFF", wsInit, wsHit, wsVictim, wsFill, wsFree, wsReport },
+};
+
+const struct replPolicyOps *findPolicy(char code) {
+	unsigned i;
+	for(i = 0; i < sizeof(replPolicies) / sizeof(replPolicies[0]); i++)
+		if(replPolicies[i].code == code)
+			return &replPolicies[i];
+	return NULL;
+}
+
+// page fault 때 쓸 frame. 빈 frame이 있으면 번호 순서대로 쓰고, 없으면 policy가 고른다.
+// 돌려받은 frame에 다른 page가 매핑돼 있으면 호출한 쪽에서 unmapFrame으로 내보내야 한다
+static inline int getFrame(struct vmSim *sim, int pid, uint64_t vpn) {
+	if(sim->nUsedFrame < sim->nFrame) {
+		sim->frames.vpn[sim->nUsedFrame] = -1;
+		return sim->nUsedFrame++;
+	}
+	return sim->policy->victim(sim, pid, vpn);
+}
+
+// frame에 매핑돼 있던 page를 내보낸다. 그 page의 프로세스에 clean/dirty eviction을 센다
+static inline void countEviction(struct vmSim *sim, int frame) {
+	if(sim->frames.vpn[frame] == -1)
+		return;
+	if(sim->frames.dirty[frame])
+		sim->procTable[sim->frames.pid[frame]].numDirtyEviction++;
+	else
+		sim->procTable[sim->frames.pid[frame]].numCleanEviction++;
+}
+
+// THP: vpn이 들어있는 영역의 resident base page 수 | THP_HUGE
+static inline uint64_t thpRegion(struct vmSim *sim, int pid, uint64_t vpn) {
+	uint64_t *region = pageMapGet(sim->thp, pageKey(pid, vpn >> THP_ORDER));
+	return region != NULL ? *region : 0;
+}
+
+// page fault로 frame에 프로세스 pid의 vpn을 매핑한다
+static inline void mapFrame(struct vmSim *sim, int frame, int pid, uint64_t vpn, char rw) {
+	sim->frames.vpn[frame] = vpn;
+	sim->frames.pid[frame] = pid;
+	sim->frames.dirty[frame] = IS_WRITE(rw);
+	if(sim->frames.filled != NULL)
+		sim->frames.filled[frame] = 0;
+	if(sim->thp != NULL)	// region의 resident base page 수
+		(*pageMapPut(sim->thp, pageKey(pid, vpn >> THP_ORDER), 0, NULL))++;
+	sim->policy->fill(sim, frame, pid, vpn);
+}
+
+#define TLB_EMPTY UINT64_MAX
+
+// set associative TLB. set은 vpn의 하위 bit로 고른다
+struct tlbState {
+	int sets, ways;
+	uint64_t *key;				// pageKey(pid, vpn). set s의 entry는 [s*ways, (s+1)*ways)
+	int *frame;
+	uint64_t *stamp;			// LRU는 마지막으로 쓴 시간, FIFO는 채운 시간
+	uint64_t now;
+	uint64_t rnd;				// random replacement용 xorshift 상태
+	int lastPid;				// flush 모드에서 마지막으로 TLB를 쓴 프로세스
+	long long numFlush;
+};
+
+static void tlbInit(struct vmSim *sim) {
+	struct tlbState *tlb;
+	int i, n = tlbConf.entries;
+
+	sim->tlb = NULL;
+	if(n == 0)
+		return;
+	tlb = (struct tlbState *)malloc(sizeof(struct tlbState));
+	tlb->ways = tlbConf.ways;
+	tlb->sets = n / tlb->ways;
+	tlb->key = (uint64_t *)malloc(sizeof(uint64_t) * n);
+	tlb->frame = (int *)malloc(sizeof(int) * n);
+	tlb->stamp = (uint64_t *)calloc(n, sizeof(uint64_t));
+	for(i = 0; i < n; i++)
+		tlb->key[i] = TLB_EMPTY;
+	tlb->now = 0;
+	tlb->rnd = 0x9e3779b97f4a7c15ULL;
+	tlb->lastPid = -1;
+	tlb->numFlush = 0;
+	sim->tlb = tlb;
+}
+
+static void tlbFree(struct vmSim *sim) {
+	if(sim->tlb == NULL)
+		return;
+	free(sim->tlb->key);
+	free(sim->tlb->frame);
+	free(sim->tlb->stamp);
+	free(sim->tlb);
+}
+
+static void tlbFlush(struct tlbState *tlb) {
+	int i;
+	for(i = 0; i < tlb->sets * tlb->ways; i++)
+		tlb->key[i] = TLB_EMPTY;
+	tlb->numFlush++;
+}
+
+// key의 translation을 TLB에서 지운다. index는 set을 고르는 번호 (vpn 또는 huge page region)
+static inline void tlbInvalidateKey(struct tlbState *tlb, uint64_t key, uint64_t index) {
+	int w, base = (index & (tlb->sets - 1)) * tlb->ways;
+
+	for(w = base; w < base + tlb->ways; w++)
+		if(tlb->key[w] == key) {
+			tlb->key[w] = TLB_EMPTY;
+			return;
+		}
+}
+
+// frame에서 내보내는 page의 translation을 TLB에서도 지운다 (shootdown)
+static inline void tlbInvalidate(struct vmSim *sim, int frame) {
+	if(sim->tlb == NULL || sim->frames.vpn[frame] == -1)
+		return;
+	tlbInvalidateKey(sim->tlb, pageKey(sim->frames.pid[frame], sim->frames.vpn[frame]), sim->frames.vpn[frame]);
+}
+
+// 프로세스 i의 key -> frameNumber 변환을 TLB에 통과시킨다. key는 base page이면 pageKey(pid, vpn)이고 index로 set을 고른다.
+// miss이면 page table walk가 한 memory reference 수(walkRefs)를 세고 TLB를 채운다
+static inline void tlbTranslateKey(struct vmSim *sim, int i, uint64_t key, uint64_t index, int frameNumber, int walkRefs) {
+	struct tlbState *tlb = sim->tlb;
+	struct procEntry *proc = &sim->procTable[i];
+	int w, base, victim;
+
+	if(!tlbConf.asid && tlb->lastPid != proc->pid) {	// ASID가 없으면 context switch마다 비운다
+		if(tlb->lastPid != -1)
+			tlbFlush(tlb);
+		tlb->lastPid = proc->pid;
+	}
+
+	base = (index & (tlb->sets - 1)) * tlb->ways;
+	victim = base;
+	tlb->now++;
+	for(w = base; w < base + tlb->ways; w++) {
+		if(tlb->key[w] == key) {	// TLB hit. 내보낸 page는 invalidate되므로 항상 현재 매핑이다
+			assert(tlb->frame[w] == frameNumber);
+			if(tlbConf.policy == 'L')
+				tlb->stamp[w] = tlb->now;
+			proc->numTLBHit++;
+			return;
+		}
+		if(tlb->key[victim] != TLB_EMPTY && (tlb->key[w] == TLB_EMPTY || tlb->stamp[w] < tlb->stamp[victim]))
+			victim = w;
+	}
+
+	proc->numTLBMiss++;
+	proc->numPTWalkRef += walkRefs;
+	if(tlbConf.policy == 'R' && tlb->key[victim] != TLB_EMPTY) {
+		tlb->rnd ^= tlb->rnd << 13;
+		tlb->rnd ^= tlb->rnd >> 7;
+		tlb->rnd ^= tlb->rnd << 17;
+		victim = base + (int)(tlb->rnd % tlb->ways);
+	}
+	tlb->key[victim] = key;
+	tlb->frame[victim] = frameNumber;
+	tlb->stamp[victim] = tlb->now;
+}
+
+// huge page로 매핑된 영역은 영역 전체가 TLB entry 하나를 쓰고 (frame 번호 대신 -1), walk는 한 level 짧다
+static inline void tlbTranslate(struct vmSim *sim, int i, uint64_t vpn, int frameNumber, int walkRefs) {
+	int pid = sim->procTable[i].pid;
+
+	if(sim->tlb == NULL)
+		return;
+	if(sim->thp != NULL && (thpRegion(sim, pid, vpn) & THP_HUGE))
+		tlbTranslateKey(sim, i, pageKey(pid, vpn >> THP_ORDER) | THP_TLBKEY, vpn >> THP_ORDER, -1, walkRefs > 1 ? walkRefs - 1 : walkRefs);
+	else
+		tlbTranslateKey(sim, i, pageKey(pid, vpn), vpn, frameNumber, walkRefs);
+}
+
+// prefetcher의 프로세스별 상태. miss의 vpn으로 학습한다
+struct prefetchProc {
+	uint64_t lastVpn;			// 마지막 miss
+	int64_t stride;				// 마지막 두 miss의 간격
+	int nmiss;					// 본 miss 수 (2에서 멈춘다)
+};
+
+struct prefetchState {
+	struct prefetchProc *proc;
+	struct pageMap next;		// Markov: pageKey(pid, vpn) -> vpn 다음에 온 miss
+};
+
+static void prefetchInit(struct vmSim *sim) {
+	sim->prefetch = NULL;
+	if(prefetchConf.kind == 0)
+		return;
+	sim->prefetch = (struct prefetchState *)malloc(sizeof(struct prefetchState));
+	sim->prefetch->proc = (struct prefetchProc *)calloc(sim->nProc, sizeof(struct prefetchProc));
+	if(prefetchConf.kind == 'm')
+		pageMapInit(&sim->prefetch->next, 1024);
+}
+
+static void prefetchFree(struct vmSim *sim) {
+	if(sim->prefetch == NULL)
+		return;
+	if(prefetchConf.kind == 'm')
+		pageMapFree(&sim->prefetch->next);
+	free(sim->prefetch->proc);
+	free(sim->prefetch);
+}
+
+// physical address로 index하는 set associative cache (L2/LLC). 모든 프로세스가 같이 쓴다.
+// 같은 크기의 fully associative LRU cache를 옆에서 같이 돌려서, 그쪽에서는 hit인 miss를 conflict miss로 센다
+#define CACHE_EMPTY UINT64_MAX
+
+struct cacheState {
+	int sets, ways, lineBits;
+	uint64_t *tag;				// physical line 번호. set s의 entry는 [s*ways, (s+1)*ways)
+	uint64_t *stamp;			// LRU
+	uint64_t now;
+	int lines;					// fully associative cache의 line 수 (sets * ways)
+	uint64_t *faLine;
+	int *faPrev, *faNext;		// LRU list. head가 가장 오래 안 쓴 slot
+	struct idxList faLru;
+	int *faFree;				// 빈 slot stack
+	int nFaFree;
+	struct pageMap faIndex;		// line -> fully associative slot. 빠진 line은 CACHE_EMPTY
+	int colors;					// page color 수 (cache way 크기 / page 크기). 1이면 coloring 효과 없음
+	long long numColorVictim;	// coloring으로 색이 맞는 frame을 고른 victim 수
+	long long numVictim;		// coloring을 시도한 victim 수
+};
+
+static void cacheInit(struct vmSim *sim) {
+	struct cacheState *cache;
+	uint64_t waySize;
+	int e;
+
+	sim->cache = NULL;
+	sim->colors = 0;
+	if(cacheConf.bytes == 0)
+		return;
+	cache = sim->cache = (struct cacheState *)malloc(sizeof(struct cacheState));
+	for(cache->lineBits = 0; (1 << cache->lineBits) < cacheConf.lineBytes; cache->lineBits++)
+		;
+	cache->ways = cacheConf.ways;
+	cache->sets = cacheConf.bytes / cacheConf.ways / cacheConf.lineBytes;
+	cache->lines = cache->sets * cache->ways;
+	cache->tag = (uint64_t *)malloc(sizeof(uint64_t) * cache->lines);
+	cache->stamp = (uint64_t *)calloc(cache->lines, sizeof(uint64_t));
+	cache->now = 0;
+	cache->faLine = (uint64_t *)malloc(sizeof(uint64_t) * cache->lines);
+	cache->faPrev = (int *)malloc(sizeof(int) * cache->lines);
+	cache->faNext = (int *)malloc(sizeof(int) * cache->lines);
+	cache->faFree = (int *)malloc(sizeof(int) * cache->lines);
+	for(e = 0; e < cache->lines; e++) {
+		cache->tag[e] = CACHE_EMPTY;
+		cache->faLine[e] = CACHE_EMPTY;
+		cache->faFree[e] = cache->lines - 1 - e;	// slot 0부터 쓴다
+	}
+	cache->nFaFree = cache->lines;
+	idxListInit(&cache->faLru);
+	pageMapInit(&cache->faIndex, 2 * cache->lines);
+	waySize = (uint64_t)cache->sets << cache->lineBits;
+	cache->colors = waySize > (1ULL << sim->pageBits) ? (int)(waySize >> sim->pageBits) : 1;
+	if(cacheConf.coloring)
+		sim->colors = cache->colors;
+	cache->numColorVictim = 0;
+	cache->numVictim = 0;
+}
+
+static void cacheFree(struct vmSim *sim) {
+	struct cacheState *cache = sim->cache;
+
+	if(cache == NULL)
+		return;
+	free(cache->tag);
+	free(cache->stamp);
+	free(cache->faLine);
+	free(cache->faPrev);
+	free(cache->faNext);
+	free(cache->faFree);
+	pageMapFree(&cache->faIndex);
+	free(cache);
+}
+
+// fully associative cache에서 slot의 line을 뺀다
+static inline void cacheFARemove(struct cacheState *cache, int slot) {
+	*pageMapGet(&cache->faIndex, cache->faLine[slot]) = CACHE_EMPTY;
+	idxListRemove(&cache->faLru, cache->faPrev, cache->faNext, slot);
+	cache->faLine[slot] = CACHE_EMPTY;
+	cache->faFree[cache->nFaFree++] = slot;
+}
+
+// frame(slow tier이면 nFrame + slot)의 page가 바뀌었다. 그 frame의 line들을 두 cache에서 지운다.
+// page가 cache보다 크면 line마다 찾는 대신 cache 전체를 훑는다
+static void cacheInvalidate(struct vmSim *sim, int frame) {
+	struct cacheState *cache = sim->cache;
+	int shift = sim->pageBits - cache->lineBits, e, w, base;
+	uint64_t line, first = (uint64_t)frame << shift, *slot;
+
+	if(shift < 31 && (1 << shift) <= cache->sets) {
+		for(line = first; line < first + (1ULL << shift); line++) {
+			base = (int)(line & (cache->sets - 1)) * cache->ways;
+			for(w = base; w < base + cache->ways; w++)
+				if(cache->tag[w] == line)
+					cache->tag[w] = CACHE_EMPTY;
+		}
+	}
+	else
+		for(e = 0; e < cache->lines; e++)
+			if(cache->tag[e] != CACHE_EMPTY && (cache->tag[e] >> shift) == (uint64_t)frame)
+				cache->tag[e] = CACHE_EMPTY;
+
+	if(shift < 31 && (1 << shift) <= cache->lines) {
+		for(line = first; line < first + (1ULL << shift); line++)
+			if((slot = pageMapGet(&cache->faIndex, line)) != NULL && *slot != CACHE_EMPTY)
+				cacheFARemove(cache, (int)*slot);
+	}
+	else
+		for(e = 0; e < cache->lines; e++)
+			if(cache->faLine[e] != CACHE_EMPTY && (cache->faLine[e] >> shift) == (uint64_t)frame)
+				cacheFARemove(cache, e);
+}
+
+// 프로세스 i가 physical address paddr를 읽는다
+static void cacheAccess(struct vmSim *sim, int i, uint64_t paddr) {
+	struct cacheState *cache = sim->cache;
+	struct procEntry *proc = &sim->procTable[i];
+	uint64_t line = paddr >> cache->lineBits, *faSlot;
+	int w, base = (int)(line & (cache->sets - 1)) * cache->ways, victim = base, hit = 0, slot;
+
+	cache->now++;
+	for(w = base; w < base + cache->ways; w++) {
+		if(cache->tag[w] == line) {
+			hit = 1;
+			victim = w;
+			break;
+		}
+		if(cache->tag[victim] != CACHE_EMPTY && (cache->tag[w] == CACHE_EMPTY || cache->stamp[w] < cache->stamp[victim]))
+			victim = w;
+	}
+	cache->tag[victim] = line;
+	cache->stamp[victim] = cache->now;
+
+	faSlot = pageMapPut(&cache->faIndex, line, CACHE_EMPTY, NULL);
+	if(hit)
+		proc->numCacheHit++;
+	else {
+		proc->numCacheMiss++;
+		if(*faSlot != CACHE_EMPTY)	// 같은 크기의 fully associative cache라면 hit
+			proc->numCacheConflict++;
+	}
+	if(*faSlot != CACHE_EMPTY) {
+		slot = (int)*faSlot;
+		idxListRemove(&cache->faLru, cache->faPrev, cache->faNext, slot);
+	}
+	else {
+		if(cache->nFaFree == 0)		// 가장 오래 안 쓴 line을 내보낸다
+			cacheFARemove(cache, cache->faLru.head);
+		slot = cache->faFree[--cache->nFaFree];
+		cache->faLine[slot] = line;
+		*pageMapGet(&cache->faIndex, line) = slot;	// pageMapPut이 table을 키웠을 수 있다
+	}
+	idxListPushTail(&cache->faLru, cache->faPrev, cache->faNext, slot);
+}
+
+// page coloring (FIFO, LRU): oldest부터 color 수만큼의 frame 중에서 (vpn + pid)와 color가 같은 첫 frame을 victim으로 고른다.
+// 없으면 oldest. 프로세스마다 color를 어긋나게 시작해서 같은 vpn들이 같은 set으로 몰리지 않게 한다
+static int colorVictim(struct vmSim *sim, int pid, uint64_t vpn) {
+	struct cacheState *cache = sim->cache;
+	uint32_t frame = sim->oldestFrame, want = (uint32_t)((vpn + pid) & (sim->colors - 1));
+	int k;
+
+	cache->numVictim++;
+	for(k = 0; k < sim->colors; k++) {
+		if((frame & (sim->colors - 1)) == want) {
+			cache->numColorVictim++;
+			return frame;
+		}
+		frame = sim->frames.link[frame].next;
+	}
+	return sim->oldestFrame;
+}
+
+// 느린 memory tier. fast tier(frame table)에서 내보낸 page를 disk 대신 받고, 가득 차면 가장 오래 안 쓴 page를 disk로 내보낸다.
+// slow tier의 page는 page table에서 빠져있고 tierAccess가 먼저 찾는다. fast tier와 겹치지 않는다 (exclusive)
+#define TIER_NONE UINT64_MAX
+
+struct tierState {
+	int *pid;					// slot마다 page의 주인 프로세스 (procTable index)
+	uint64_t *vpn;
+	unsigned char *dirty;
+	uint64_t *count;			// slow tier에 내려온 뒤의 access 수
+	uint64_t *last;				// 마지막 access (또는 demotion) 시각
+	int *prev, *next;			// LRU list. head가 가장 오래 안 쓴 slot
+	struct idxList lru;
+	int *freeSlot;				// 빈 slot stack
+	int nFree;
+	struct pageMap index;		// pageKey(pid, vpn) -> slot. 빠진 page는 TIER_NONE
+	uint64_t now;				// access 수 (recency 기준 시각)
+};
+
+static void tierInit(struct vmSim *sim) {
+	struct tierState *tier;
+	int n = tierConf.frames, s;
+
+	sim->tier = NULL;
+	if(n == 0)
+		return;
+	tier = sim->tier = (struct tierState *)malloc(sizeof(struct tierState));
+	tier->pid = (int *)malloc(sizeof(int) * n);
+	tier->vpn = (uint64_t *)malloc(sizeof(uint64_t) * n);
+	tier->dirty = (unsigned char *)malloc(n);
+	tier->count = (uint64_t *)malloc(sizeof(uint64_t) * n);
+	tier->last = (uint64_t *)malloc(sizeof(uint64_t) * n);
+	tier->prev = (int *)malloc(sizeof(int) * n);
+	tier->next = (int *)malloc(sizeof(int) * n);
+	tier->freeSlot = (int *)malloc(sizeof(int) * n);
+	for(s = 0; s < n; s++)		// slot 0부터 쓴다
+		tier->freeSlot[s] = n - 1 - s;
+	tier->nFree = n;
+	idxListInit(&tier->lru);
+	pageMapInit(&tier->index, 1024);
+	tier->now = 0;
+}
+
+static void tierFree(struct vmSim *sim) {
+	struct tierState *tier = sim->tier;
+
+	if(tier == NULL)
+		return;
+	free(tier->pid);
+	free(tier->vpn);
+	free(tier->dirty);
+	free(tier->count);
+	free(tier->last);
+	free(tier->prev);
+	free(tier->next);
+	free(tier->freeSlot);
+	pageMapFree(&tier->index);
+	free(tier);
+}
+
+// slot을 비운다. page의 translation은 TLB에서도 지운다
+static void tierRelease(struct vmSim *sim, int slot) {
+	struct tierState *tier = sim->tier;
+	uint64_t key = pageKey(tier->pid[slot], tier->vpn[slot]);
+
+	*pageMapGet(&tier->index, key) = TIER_NONE;
+	if(sim->tlb != NULL)
+		tlbInvalidateKey(sim->tlb, key, tier->vpn[slot]);
+	if(sim->cache != NULL)
+		cacheInvalidate(sim, sim->nFrame + slot);
+	idxListRemove(&tier->lru, tier->prev, tier->next, slot);
+	tier->freeSlot[tier->nFree++] = slot;
+}
+
+// fast tier에서 내보내는 frame의 page를 slow tier로 내린다 (demotion).
+// slow tier가 가득 차 있으면 가장 오래 안 쓴 page를 disk로 내보내고 그 page의 주인에 clean/dirty eviction을 센다
+static void tierDemote(struct vmSim *sim, int frame) {
+	struct tierState *tier = sim->tier;
+	int pid = sim->frames.pid[frame], slot;
+	uint64_t vpn = sim->frames.vpn[frame];
+
+	if(tier->nFree == 0) {
+		slot = tier->lru.head;
+		if(tier->dirty[slot])
+			sim->procTable[tier->pid[slot]].numDirtyEviction++;
+		else
+			sim->procTable[tier->pid[slot]].numCleanEviction++;
+		tierRelease(sim, slot);
+	}
+	slot = tier->freeSlot[--tier->nFree];
+	tier->pid[slot] = pid;
+	tier->vpn[slot] = vpn;
+	tier->dirty[slot] = sim->frames.dirty[frame];
+	tier->count[slot] = 0;
+	tier->last[slot] = tier->now;
+	idxListPushTail(&tier->lru, tier->prev, tier->next, slot);
+	*pageMapPut(&tier->index, pageKey(pid, vpn), slot, NULL) = slot;
+	sim->procTable[pid].numTierDemotion++;
+}
+
+// 프로세스 i의 vpn이 slow tier에 있으면 꺼내서 (fast tier로 올린다) dirty bit를 돌려준다. 없으면 0
+static int tierTake(struct vmSim *sim, int i, uint64_t vpn) {
+	struct tierState *tier = sim->tier;
+	uint64_t *slot = pageMapGet(&tier->index, pageKey(sim->procTable[i].pid, vpn));
+	int dirty;
+
+	if(slot == NULL || *slot == TIER_NONE)
+		return 0;
+	dirty = tier->dirty[*slot];
+	tierRelease(sim, (int)*slot);
+	sim->procTable[i].numTierPromotion++;
+	return dirty;
+}
+
+// page 크기별로 따로 compile한 access kernel (vmSimAccess 참고)
+static void accessPage4K(struct vmSim *sim, int i, uint64_t addr, char rw);
+static void accessPage2M(struct vmSim *sim, int i, uint64_t addr, char rw);
+static void accessPage1G(struct vmSim *sim, int i, uint64_t addr, char rw);
+static void accessPageAny(struct vmSim *sim, int i, uint64_t addr, char rw);
+
+// 시뮬레이터 instance 생성. procTable의 앞 nProc개 프로세스의 trace 정보(traceName)를 복사하고 통계는 0으로 시작한다.
+// pid는 instance 안에서의 index로 다시 붙인다. page 크기(pageBits)와 two-level의 firstLevelBits(levelBits)는 instance마다 따로 가진다
+void initVMSimBits(struct vmSim *sim, char type, char policy, struct procEntry *procTable, int nProc, int nFrame,
+		int pageBits, int levelBits) {
+	int i;
+
+	sim->type = type;
+	sim->out = s_flag ? sinkOpen() : NULL;
+	sim->policy = findPolicy(policy);
+	assert(sim->policy != NULL);
+	sim->nFrame = nFrame;
+	sim->nProc = nProc;
+	sim->lastPid = -1;
+	sim->pageBits = pageBits;
+	if(pageBits == 12)
+		sim->access = accessPage4K;
+	else if(pageBits == 21)
+		sim->access = accessPage2M;
+	else if(pageBits == 30)
+		sim->access = accessPage1G;
+	else
+		sim->access = accessPageAny;
+	sim->thp = NULL;
+	if(thpConf.threshold && (type == '0' || type == '4')) {
+		sim->thp = (struct pageMap *)malloc(sizeof(struct pageMap));
+		pageMapInit(sim->thp, 1024);
+	}
+	prefetchInit(sim);
+	tierInit(sim);
+	cacheInit(sim);
+	initPhyMem(sim);
+	sim->policyState = NULL;
+	sim->policy->init(sim);
+	tlbInit(sim);
+
+	if(type == '0')
+		snprintf(sim->title, sizeof(sim->title), "The One-Level Page Table with %s Memory Simulation Starts .....", sim->policy->name);
+	else if(type == '4' && policy == 'L')
+		snprintf(sim->title, sizeof(sim->title), "The %d-Level Page Table Memory Simulation Starts .....", radixConf.levels);
+	else if(type == '4')
+		snprintf(sim->title, sizeof(sim->title), "The %d-Level Page Table with %s Memory Simulation Starts .....", radixConf.levels, sim->policy->name);
+	else if(policy == 'L')	// two-level과 inverted의 기본 policy
+		snprintf(sim->title, sizeof(sim->title), "The %s Page Table Memory Simulation Starts .....", type == '1' ? "Two-Level" : "Inverted");
+	else
+		snprintf(sim->title, sizeof(sim->title), "The %s Page Table with %s Memory Simulation Starts .....", type == '1' ? "Two-Level" : "Inverted", sim->policy->name);
+
+	sim->procTable = (struct procEntry *)malloc(sizeof(struct procEntry) * nProc);
+	for(i = 0; i < nProc; i++) {
+		sim->procTable[i] = procTable[i];
+		sim->procTable[i].pid = i;
+		sim->procTable[i].ntraces = 0;
+		sim->procTable[i].num2ndLevelPageTable = 0;
+		sim->procTable[i].numIHTConflictAccess = 0;
+		sim->procTable[i].numIHTNULLAccess = 0;
+		sim->procTable[i].numIHTNonNULLAcess = 0;
+		sim->procTable[i].numPageFault = 0;
+		sim->procTable[i].numPageHit = 0;
+		sim->procTable[i].numCleanEviction = 0;
+		sim->procTable[i].numDirtyEviction = 0;
+		sim->procTable[i].numTLBHit = 0;
+		sim->procTable[i].numTLBMiss = 0;
+		sim->procTable[i].numPTWalkRef = 0;
+		sim->procTable[i].numContextSwitch = 0;
+		sim->procTable[i].numPromotion = 0;
+		sim->procTable[i].numDemotion = 0;
+		sim->procTable[i].numPromoteFill = 0;
+		sim->procTable[i].numFaultAvoided = 0;
+		sim->procTable[i].numPrefetch = 0;
+		sim->procTable[i].numPrefetchUseful = 0;
+		sim->procTable[i].numPrefetchHarmful = 0;
+		sim->procTable[i].numSlowHit = 0;
+		sim->procTable[i].numTierPromotion = 0;
+		sim->procTable[i].numTierDemotion = 0;
+		sim->procTable[i].numCacheHit = 0;
+		sim->procTable[i].numCacheMiss = 0;
+		sim->procTable[i].numCacheConflict = 0;
+		memset(sim->procTable[i].numRadixTable, 0, sizeof(sim->procTable[i].numRadixTable));
+		sim->procTable[i].firstLevelPageTable = NULL;
+		sim->procTable[i].radixRoot = NULL;
+		sim->procTable[i].oneLevelDir = NULL;
+		sim->procTable[i].numPTEChunk = 0;
+	}
+
+	sim->firstLevelBits = levelBits;
+	sim->twoLevelBits = 32 - sim->pageBits - levelBits;
+	sim->firstLevelPageTableSize = 1 << sim->firstLevelBits;
+	sim->twoLevelPageTableSize = 1 << sim->twoLevelBits;
+	sim->invertedPageTable = NULL;
+	sim->iptNodes = NULL;
+	sim->iptSlots = NULL;
+	sim->iptSize = 0;
+	sim->iptHash = iptConf.hash;
+	arenaInit(&sim->tableArena);
+
+	if(type == '0') {
+		// PageTable 동적할당으로 생성
+		for(i = 0; i < sim->nProc; i++)
+			sim->procTable[i].oneLevelDir = (pte_t **)calloc(PTEDIRSIZE, sizeof(pte_t *));
+	}
+	else if(type == '1') {
+		// first Page Table 동적할당으로 생성
+		for(i = 0; i < sim->nProc; i++)
+			sim->procTable[i].firstLevelPageTable = (struct pageTableEntry *)calloc(sim->firstLevelPageTableSize, sizeof(struct pageTableEntry));
+	}
+	else if(type == '4') {
+		for(i = 0; i < sim->nProc; i++) {
+			sim->procTable[i].radixRoot = (uint64_t *)arenaAlloc(&sim->tableArena, sizeof(uint64_t) << radixConf.bits[0]);
+			sim->procTable[i].numRadixTable[0] = 1;
+		}
+	}
+	else {
+		if(iptConf.slots != 0)
+			sim->iptSize = iptConf.slots;
+		else	// open addressing은 load factor 0.5로 시작
+			sim->iptSize = iptConf.backend == 'o' ? 2 * nFrame : nFrame;
+		if(iptConf.backend == 'o') {
+			sim->iptSlots = (struct iptSlot *)malloc(sizeof(struct iptSlot) * sim->iptSize);
+			for(i = 0; i < sim->iptSize; i++)
+				sim->iptSlots[i].key = PAGEMAP_EMPTY;
+		}
+		else {
+			sim->invertedPageTable = (struct invertedPageTableEntry *)malloc(sizeof(struct invertedPageTableEntry) * sim->iptSize);
+			sim->iptNodes = (struct invertedPageTableEntry *)malloc(sizeof(struct invertedPageTableEntry) * nFrame);
+
+			// initialize invertedPageTable
+			for(i = 0; i < sim->iptSize; i++) {
+				sim->invertedPageTable[i].pid = -1;
+				sim->invertedPageTable[i].virtualPageNumber = -1;
+				sim->invertedPageTable[i].frameNumber = -1;
+				sim->invertedPageTable[i].next = NULL;
+			}
+		}
+	}
+}
+
+// -P와 firstLevelBits로 instance 생성
+void initVMSim(struct vmSim *sim, char type, char policy, struct procEntry *procTable, int nProc, int nFrame) {
+	initVMSimBits(sim, type, policy, procTable, nProc, nFrame, pageSizeBits, firstLevelBits);
+}
+
+void freeVMSim(struct vmSim *sim) {
+	int i, j;
+
+	for(i = 0; i < sim->nProc; i++) {
+		if(sim->type == '1' && sim->procTable[i].firstLevelPageTable != NULL)
+			for(j = 0; j < sim->firstLevelPageTableSize; j++)
+				free(sim->procTable[i].firstLevelPageTable[j].secondLevelPageTable);
+		free(sim->procTable[i].firstLevelPageTable);
+		free(sim->procTable[i].oneLevelDir);	// chunk들은 tableArena에 있다
+	}
+	free(sim->invertedPageTable);
+	free(sim->iptNodes);
+	free(sim->iptSlots);
+	arenaFree(&sim->tableArena);
+	free(sim->procTable);
+	sim->policy->free(sim);
+	tlbFree(sim);
+	freePhyMem(sim);
+	if(sim->thp != NULL) {
+		pageMapFree(sim->thp);
+		free(sim->thp);
+	}
+	prefetchFree(sim);
+	tierFree(sim);
+	cacheFree(sim);
+	if(sim->out != NULL)
+		sinkClose(sim->out);
+}
+
+const char *vmSimTitle(struct vmSim *sim) {
+	return sim->title;
+}
+
+// inverted page table의 hash. (pid, vpn)을 [0, iptSize)의 bucket으로 보낸다
+static inline unsigned iptHash(struct vmSim *sim, int pid, uint64_t vpn) {
+	uint64_t h;
+
+	if(sim->iptHash == 'm')		// 원래의 (vpn + pid) % size. 이웃한 pid의 이웃한 page가 몰린다
+		return (vpn + pid) % sim->iptSize;
+	if(sim->iptHash == 'f')		// Fibonacci (multiplicative) hashing
+		h = pageKey(pid, vpn) * 0x9e3779b97f4a7c15ULL;
+	else
+		h = mix64(pageKey(pid, vpn));
+	return (unsigned)(((h >> 32) * (uint64_t)sim->iptSize) >> 32);	// % 없이 [0, iptSize)로 줄인다
+}
+
+// one-level table에서 vpn의 PTE. chunk가 아직 없으면 NULL
+static inline pte_t *oneLevelPTE(struct procEntry *proc, unsigned vpn) {
+	pte_t *chunk = proc->oneLevelDir[vpn >> PTECHUNKBITS];
+	return chunk != NULL ? &chunk[vpn & (PTECHUNKSIZE - 1)] : NULL;
+}
+
+// vpn의 PTE. 이 영역을 처음 건드리면 PTE chunk를 만든다
+static inline pte_t *oneLevelPTEAlloc(struct vmSim *sim, struct procEntry *proc, unsigned vpn) {
+	if(proc->oneLevelDir[vpn >> PTECHUNKBITS] == NULL) {
+		proc->oneLevelDir[vpn >> PTECHUNKBITS] = (pte_t *)arenaAlloc(&sim->tableArena, sizeof(pte_t) * PTECHUNKSIZE);
+		proc->numPTEChunk++;
+	}
+	return oneLevelPTE(proc, vpn);
+}
+
+// N-level radix table에서 vpn의 leaf entry. 중간 table이 없으면 create일 때 만들고, 아니면 NULL
+static uint64_t *radixLeaf(struct vmSim *sim, struct procEntry *proc, uint64_t vpn, int create) {
+	uint64_t *table = proc->radixRoot, *entry;
+	int l, shift = radixConf.vaBits - sim->pageBits;
+
+	for(l = 0; ; l++) {
+		shift -= radixConf.bits[l];
+		entry = &table[(vpn >> shift) & ((1ULL << radixConf.bits[l]) - 1)];
+		if(l == radixConf.levels - 1)
+			return entry;
+		if(*entry == 0) {
+			if(!create)
+				return NULL;
+			*entry = (uintptr_t)arenaAlloc(&sim->tableArena, sizeof(uint64_t) << radixConf.bits[l + 1]);
+			proc->numRadixTable[l + 1]++;
+		}
+		table = (uint64_t *)(uintptr_t)*entry;
+	}
+}
+
+// fault 없이 채운 page의 첫 access. THP 승격으로 채운 page이면 피한 fault를, prefetch한 page이면 useful prefetch를 센다.
+// prefetch한 page였으면 1을 돌려준다 (prefetcher에게는 page fault와 같은 miss다)
+static inline int fillTouch(struct vmSim *sim, int i, int frame) {
+	unsigned char fill;
+
+	if(sim->frames.filled == NULL || (fill = sim->frames.filled[frame]) == 0)
+		return 0;
+	sim->frames.filled[frame] = 0;
+	if(fill == FILL_THP) {
+		sim->procTable[i].numFaultAvoided++;
+		return 0;
+	}
+	sim->procTable[i].numPrefetchUseful++;
+	return 1;
+}
+
+// 프로세스 i의 vpn이 매핑돼 있는지. access가 아니므로 통계는 세지 않는다
+static int pageResident(struct vmSim *sim, int i, uint64_t vpn) {
+	struct procEntry *proc = &sim->procTable[i];
+	struct pageTableEntry *pt1;
+	struct invertedPageTableEntry *entry;
+	uint64_t key, *leaf;
+	unsigned slot;
+	pte_t *pte;
+
+	if(sim->type == '0')
+		return (pte = oneLevelPTE(proc, vpn)) != NULL && (*pte & PTE_VALID);
+	if(sim->type == '1') {
+		pt1 = &proc->firstLevelPageTable[vpn >> sim->twoLevelBits];
+		return pt1->valid == '1' && pt1->secondLevelPageTable[vpn & (sim->twoLevelPageTableSize - 1)].valid == '1';
+	}
+	if(sim->type == '4')
+		return (leaf = radixLeaf(sim, proc, vpn, 0)) != NULL && *leaf != 0;
+	if(sim->iptSlots != NULL) {
+		key = pageKey(proc->pid, vpn);
+		for(slot = iptHash(sim, proc->pid, vpn); sim->iptSlots[slot].key != PAGEMAP_EMPTY; slot = (slot + 1) % sim->iptSize)
+			if(sim->iptSlots[slot].key == key)
+				return 1;
+		return 0;
+	}
+	for(entry = sim->invertedPageTable[iptHash(sim, proc->pid, vpn)].next; entry != NULL; entry = entry->next)
+		if(entry->pid == proc->pid && entry->virtualPageNumber == (int)vpn)
+			return 1;
+	return 0;
+}
+
+// access 없이 프로세스 i의 vpn을 매핑하고 frame을 돌려준다 (prefetch, THP 승격, slow tier에서 promotion).
+// frame은 page fault와 같이 policy가 고르고, page table에는 각 access 함수의 fault 처리와 같이 넣는다.
+// slow tier에 있던 page는 먼저 꺼낸다 (frame을 비우며 내린 page가 slow tier에서 밀어내지 않도록)
+static int installPage(struct vmSim *sim, int i, uint64_t vpn) {
+	struct procEntry *proc = &sim->procTable[i];
+	struct pageTableEntry *pt1;
+	struct invertedPageTableEntry *node, *bucket;
+	uint64_t *leaf;
+	unsigned slot;
+	int frame, dirty;
+
+	dirty = sim->tier != NULL ? tierTake(sim, i, vpn) : 0;
+	frame = getFrame(sim, proc->pid, vpn);
+	unmapFrame(sim, frame);
+	if(sim->type == '0')
+		*oneLevelPTEAlloc(sim, proc, vpn) = PTE_VALID | frame;
+	else if(sim->type == '1') {
+		pt1 = &proc->firstLevelPageTable[vpn >> sim->twoLevelBits];
+		if(pt1->valid != '1') {
+			pt1->secondLevelPageTable = (struct pageTableEntry2 *)calloc(sim->twoLevelPageTableSize, sizeof(struct pageTableEntry2));
+			proc->num2ndLevelPageTable++;
+			pt1->valid = '1';
+		}
+		pt1->secondLevelPageTable[vpn & (sim->twoLevelPageTableSize - 1)].frameNumber = frame;
+		pt1->secondLevelPageTable[vpn & (sim->twoLevelPageTableSize - 1)].valid = '1';
+	}
+	else if(sim->type == '4') {
+		leaf = radixLeaf(sim, proc, vpn, 1);
+		*leaf = frame + 1;
+		sim->frames.pte[frame] = leaf;
+	}
+	else if(sim->iptSlots != NULL) {
+		for(slot = iptHash(sim, proc->pid, vpn); sim->iptSlots[slot].key != PAGEMAP_EMPTY; slot = (slot + 1) % sim->iptSize)
+			;
+		sim->iptSlots[slot].key = pageKey(proc->pid, vpn);
+		sim->iptSlots[slot].frameNumber = frame;
+	}
+	else {
+		node = &sim->iptNodes[frame];
+		bucket = &sim->invertedPageTable[iptHash(sim, proc->pid, vpn)];
+		node->pid = proc->pid;
+		node->virtualPageNumber = vpn;
+		node->frameNumber = frame;
+		node->next = bucket->next;
+		bucket->next = node;
+	}
+	mapFrame(sim, frame, proc->pid, vpn, 'R');
+	sim->frames.dirty[frame] = dirty;
+	return frame;
+}
+
+// fault로 vpn이 들어온 뒤 영역의 resident base page가 threshold개 이상이면 나머지 page를 채워서 huge page로 승격한다.
+// 채우는 동안 policy가 같은 영역의 page를 내보내면 이번에는 승격하지 않는다
+static void thpPromote(struct vmSim *sim, int i, uint64_t vpn) {
+	struct procEntry *proc = &sim->procTable[i];
+	uint64_t first = vpn & ~((1ULL << THP_ORDER) - 1), v, region;
+
+	region = thpRegion(sim, proc->pid, vpn);
+	if((region & THP_HUGE) || (region & THP_COUNT) < (uint64_t)thpConf.threshold || sim->nFrame < (1 << THP_ORDER))
+		return;
+	for(v = first; v < first + (1ULL << THP_ORDER); v++)
+		if(!pageResident(sim, i, v)) {
+			sim->frames.filled[installPage(sim, i, v)] = FILL_THP;
+			proc->numPromoteFill++;
+		}
+	if((thpRegion(sim, proc->pid, vpn) & THP_COUNT) == (1ULL << THP_ORDER)) {
+		*pageMapGet(sim->thp, pageKey(proc->pid, vpn >> THP_ORDER)) |= THP_HUGE;
+		proc->numPromotion++;
+	}
+}
+
+// 프로세스 i의 vpn에서 miss(page fault 또는 prefetch한 page의 첫 access)가 났다.
+// prefetcher를 학습시키고, 예측한 page 중 매핑돼 있지 않은 것들을 policy를 거쳐 채운다
+static void prefetchPages(struct vmSim *sim, int i, uint64_t vpn) {
+	struct prefetchProc *p = &sim->prefetch->proc[i];
+	int pid = sim->procTable[i].pid;
+	uint64_t limit, v = vpn, *next;
+	int64_t stride = 1;
+	int k;
+
+	if(prefetchConf.kind == 'm') {		// 이전 miss 다음에 vpn이 왔다
+		if(p->nmiss > 0)
+			*pageMapPut(&sim->prefetch->next, pageKey(pid, p->lastVpn), vpn, NULL) = vpn;
+	}
+	else if(prefetchConf.kind == 's') {	// 같은 간격이 두 번 연속이면 그 간격으로 앞서 읽는다
+		stride = (int64_t)(vpn - p->lastVpn);
+		if(p->nmiss < 2 || stride != p->stride || stride == 0) {
+			p->stride = p->nmiss > 0 ? stride : 0;
+			stride = 0;
+		}
+	}
+	p->lastVpn = vpn;
+	if(p->nmiss < 2)
+		p->nmiss++;
+	if(stride == 0)
+		return;
+
+	// 32bit page table은 32bit 주소 공간 안의 page만 있다. 음수 stride로 0 아래로 내려가도 limit를 넘는다
+	limit = 1ULL << ((sim->type == '4' ? radixConf.vaBits : VIRTUALADDRBITS) - sim->pageBits);
+	for(k = 0; k < prefetchConf.degree; k++) {
+		if(prefetchConf.kind == 'm') {
+			if((next = pageMapGet(&sim->prefetch->next, pageKey(pid, v))) == NULL)
+				break;
+			v = *next;
+		}
+		else
+			v += stride;
+		if(v >= limit)
+			break;
+		if(v == vpn || pageResident(sim, i, v))
+			continue;
+		sim->frames.filled[installPage(sim, i, v)] = FILL_PREFETCH;
+		sim->procTable[i].numPrefetch++;
+	}
+}
+
+// access 전에 slow tier를 먼저 본다. page가 없으면 0을 돌려주고 page table로 간다.
+// 있으면 promotion policy가 고르는 대로 fast tier로 올리거나 slow tier에서 그대로 access하고 1을 돌려준다.
+// 어느 쪽이든 slow tier hit이다 (page table의 hit/fault와 IHT 통계에는 들어가지 않는다)
+static int tierAccess(struct vmSim *sim, int i, uint64_t addr, char rw) {
+	struct tierState *tier = sim->tier;
+	struct procEntry *proc = &sim->procTable[i];
+	uint64_t vpn, *p;
+	int slot, frameNumber;
+
+	if(sim->type == '4')
+		vpn = (radixConf.vaBits < 64 ? addr & ((1ULL << radixConf.vaBits) - 1) : addr) >> sim->pageBits;
+	else
+		vpn = (unsigned)addr >> sim->pageBits;
+	tier->now++;
+	if((p = pageMapGet(&tier->index, pageKey(proc->pid, vpn))) == NULL || *p == TIER_NONE)
+		return 0;
+	slot = (int)*p;
+	proc->ntraces++;
+	proc->numSlowHit++;
+	tier->count[slot]++;
+	if(tierConf.promote == 'f' ? tier->count[slot] >= tierConf.threshold : tier->now - tier->last[slot] <= tierConf.threshold) {
+		frameNumber = installPage(sim, i, vpn);
+		sim->frames.dirty[frameNumber] |= IS_WRITE(rw);
+	}
+	else {	// slow frame 번호는 fast tier 뒤에 붙인다
+		tier->dirty[slot] |= IS_WRITE(rw);
+		tier->last[slot] = tier->now;
+		idxListRemove(&tier->lru, tier->prev, tier->next, slot);
+		idxListPushTail(&tier->lru, tier->prev, tier->next, slot);
+		frameNumber = sim->nFrame + slot;
+	}
+	tlbTranslate(sim, i, vpn, frameNumber, 1);
+	if(sim->cache != NULL)
+		cacheAccess(sim, i, ((uint64_t)frameNumber << sim->pageBits) | (addr & (((uint64_t)1 << sim->pageBits) - 1)));
+	if(sim->out != NULL)
+		sinkTranslation(sim->out, SINK_SLOWTIER, proc->pid, proc->ntraces, sim->type == '4' ? addr : (unsigned)addr,
+				((uint64_t)frameNumber << sim->pageBits) | (addr & (((uint64_t)1 << sim->pageBits) - 1)),
+				XLATE_SLOWTIER | (frameNumber < sim->nFrame ? XLATE_PROMOTED : 0));
+	return 1;
+}
+
+// page 크기별 kernel에 펼쳐 넣는 access 함수들. pageBits가 상수로 들어오면 shift와 mask도 상수가 된다
+#define PAGE_KERNEL static inline __attribute__((always_inline))
+
+PAGE_KERNEL void oneLevelAccess(struct vmSim *sim, int i, unsigned addr, char rw, const int pageBits) {
+	struct procEntry *procTable = sim->procTable;
+	int frame, fault = 0, miss = 0;
+	unsigned Vaddr, offset;
+	uint64_t Paddr;
+	pte_t *pte;
+
+	Vaddr = addr >> pageBits;
+	offset = addr & ((1u << pageBits) - 1); // offset
+	pte = oneLevelPTE(&procTable[i], Vaddr);
+
+	// pageHit
+	if(pte != NULL && (*pte & PTE_VALID)) {
+		procTable[i].numPageHit++;
+		*pte |= PTE_REFERENCED | (IS_WRITE(rw) ? PTE_DIRTY : 0);
+		sim->frames.dirty[*pte & PTE_FRAMEMASK] |= IS_WRITE(rw);
+		miss = fillTouch(sim, i, *pte & PTE_FRAMEMASK);
+		sim->policy->hit(sim, *pte & PTE_FRAMEMASK);
+	}
+
+	// pageFault
+	else {
+		procTable[i].numPageFault++;
+		fault = miss = 1;
+
+		// pageFault 발생 시 policy가 고른 frame을 맵핑해주고 frame table에 맵핑된 procTable 정보 저장
+		frame = getFrame(sim, procTable[i].pid, Vaddr);
+		unmapFrame(sim, frame);
+
+		if(pte == NULL)	// 이 영역을 처음 건드림. PTE chunk 생성
+			pte = oneLevelPTEAlloc(sim, &procTable[i], Vaddr);
+		*pte = PTE_VALID | PTE_REFERENCED | (IS_WRITE(rw) ? PTE_DIRTY : 0) | frame;
+		mapFrame(sim, frame, procTable[i].pid, Vaddr, rw);
+	}
+
+	tlbTranslate(sim, i, Vaddr, *pte & PTE_FRAMEMASK, 1);
+	Paddr = ((uint64_t)(*pte & PTE_FRAMEMASK) << pageBits) + offset;
+
+	procTable[i].ntraces++;
+	if(sim->cache != NULL)
+		cacheAccess(sim, i, Paddr);
+
+	// -s option print statement
+	if(sim->out != NULL)
+		sinkTranslation(sim->out, SINK_ONELEVEL, i, procTable[i].ntraces, addr, Paddr, fault ? XLATE_FAULT : 0);
+	if(miss && sim->prefetch != NULL)
+		prefetchPages(sim, i, Vaddr);
+	if(fault && sim->thp != NULL)
+		thpPromote(sim, i, Vaddr);
+}
+
+PAGE_KERNEL void twoLevelAccess(struct vmSim *sim, int i, unsigned addr, char rw, const int pageBits) {
+	struct procEntry *procTable = sim->procTable;
+	int frame, fault = 0, miss = 0;
+	unsigned offset, fVPN, sVPN;
+	uint64_t Paddr;
+	int walkRefs;
+
+	fVPN = (addr >> pageBits) >> sim->twoLevelBits;
+	sVPN = (addr << sim->firstLevelBits) >> pageBits >> sim->firstLevelBits;
+	offset = addr & ((1u << pageBits) - 1);	// offset = 하위 pageBits bits
+	walkRefs = procTable[i].firstLevelPageTable[fVPN].valid == '1' ? 2 : 1;	// PT1이 invalid이면 PT2는 읽지 않는다
+
+	// pageHit
+	if(procTable[i].firstLevelPageTable[fVPN].valid == '1' && procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].valid == '1')
+	{
+		procTable[i].numPageHit++;
+		sim->frames.dirty[procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber] |= IS_WRITE(rw);
+		miss = fillTouch(sim, i, procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber);
+		sim->policy->hit(sim, procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber);
+	}
+
+	// PT1 또는 PT2에서의 page Fault
+	else
+	{
+		procTable[i].numPageFault++;
+		fault = miss = 1;
+
+		// pageFault 발생 시 policy가 고른 frame을 맵핑해주고 frame table에 맵핑된 procTable 정보 저장
+		frame = getFrame(sim, procTable[i].pid, addr >> pageBits);
+		unmapFrame(sim, frame);
+
+		if(procTable[i].firstLevelPageTable[fVPN].valid != '1') {	// PT1에서의 page Fault. 2nd level page table 생성
+			procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable = (struct pageTableEntry2 *)calloc(sim->twoLevelPageTableSize, sizeof(struct pageTableEntry2));
+			procTable[i].num2ndLevelPageTable++;
+			procTable[i].firstLevelPageTable[fVPN].valid = '1';
+		}
+		procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber = frame;
+		procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].valid = '1';
+		mapFrame(sim, frame, procTable[i].pid, addr >> pageBits, rw);
+	}
+
+	tlbTranslate(sim, i, addr >> pageBits, procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber, walkRefs);
+	procTable[i].ntraces++;
+	Paddr = ((uint64_t)procTable[i].firstLevelPageTable[fVPN].secondLevelPageTable[sVPN].frameNumber << pageBits) + offset;
+	if(sim->cache != NULL)
+		cacheAccess(sim, i, Paddr);
+	// -s option print statement
+	if(sim->out != NULL)
+		sinkTranslation(sim->out, SINK_TWOLEVEL, i, procTable[i].ntraces, addr, Paddr, fault ? XLATE_FAULT : 0);
+	if(miss && sim->prefetch != NULL)
+		prefetchPages(sim, i, addr >> pageBits);
+}
+
+// frame에 맵핑돼있던 항목을 inverted page table에서 삭제
+static void invertedUnmap(struct vmSim *sim, int frame) {
+	struct invertedPageTableEntry *invertedPageTable = sim->invertedPageTable;
+	struct invertedPageTableEntry *del = &sim->iptNodes[frame];
+	struct invertedPageTableEntry *prev;
+
+	if(sim->frames.vpn[frame] == -1)
+		return;
+
+	// frame의 entry는 iptNodes[frame번호]이므로 찾을 필요 없이 앞 entry만 찾아 연결을 끊는다
+	prev = &invertedPageTable[iptHash(sim, sim->frames.pid[frame], sim->frames.vpn[frame])];
+	while(prev->next != del)
+		prev = prev->next;
+	prev->next = del->next;
+}
+
+PAGE_KERNEL void invertedAccess(struct vmSim *sim, int i, unsigned addr, char rw, const int pageBits) {
+	struct procEntry *procTable = sim->procTable;
+	struct invertedPageTableEntry *invertedPageTable = sim->invertedPageTable;
+	struct invertedPageTableEntry *newEntry;
+	int frame, fault = 0, miss = 0;
+	unsigned offset, IPN, IPTindex;
+	uint64_t Paddr;
+	int walkRefs = 1;			// 살펴본 hash chain entry 수. 빈 bucket도 한 번은 읽는다
+
+	IPN = addr >> pageBits;
+	IPTindex = iptHash(sim, procTable[i].pid, IPN);
+	offset = addr & ((1u << pageBits) - 1);	// offset = 하위 pageBits bits
+
+	// Entry가 존재하지 않는 경우
+	if(invertedPageTable[IPTindex].next == NULL)
+	{
+		// page fault
+		procTable[i].numIHTNULLAccess++;
+		procTable[i].numPageFault++;
+	}
+	// Entry가 존재하는 경우
+	else
+	{
+		procTable[i].numIHTNonNULLAcess++;
+		procTable[i].numIHTConflictAccess++;
+
+		struct invertedPageTableEntry * searching = invertedPageTable[IPTindex].next;
+
+		while(searching != NULL)	// entry 전체 탐색
+		{
+			if((searching->pid == procTable[i].pid) && (searching->virtualPageNumber == (int)IPN))
+			{
+				// Page Hit
+				procTable[i].numPageHit++;
+
+				// 찾은 entry에 해당하는 frame 위치 갱신
+				sim->frames.dirty[searching->frameNumber] |= IS_WRITE(rw);
+				miss = fillTouch(sim, i, searching->frameNumber);
+				sim->policy->hit(sim, searching->frameNumber);
+
+				Paddr = ((uint64_t)searching->frameNumber << pageBits) + offset;
+				goto translated;
+			}
+
+			else
+			{
+				searching = searching->next;
+				if(searching != NULL) {
+					procTable[i].numIHTConflictAccess++;
+					walkRefs++;
+				}
+			}
+		}
+
+		// entry에 존재하지 않는 경우. page fault
+		procTable[i].numPageFault++;
+	}
+
+	fault = miss = 1;
+	frame = getFrame(sim, procTable[i].pid, IPN);
+	// frame에 맵핑돼있던 항목 삭제. entry는 frame마다 하나씩 미리 할당해 두었으므로 그대로 다시 쓴다
+	unmapFrame(sim, frame);
+
+	// 새로운 항목 entry 맨 앞에 삽입하기
+	newEntry = &sim->iptNodes[frame];
+	newEntry->pid = procTable[i].pid;
+	newEntry->virtualPageNumber = IPN;
+	newEntry->frameNumber = frame;
+	newEntry->next = invertedPageTable[IPTindex].next;
+	invertedPageTable[IPTindex].next = newEntry;
+
+	// frame 정보 갱신
+	mapFrame(sim, frame, procTable[i].pid, IPN, rw);
+
+	Paddr = ((uint64_t)frame << pageBits) + offset;
+
+translated:
+	tlbTranslate(sim, i, IPN, Paddr >> pageBits, walkRefs);
+	procTable[i].ntraces++;
+	if(sim->cache != NULL)
+		cacheAccess(sim, i, Paddr);
+	// -s option print statement
+	if(sim->out != NULL)
+		sinkTranslation(sim->out, SINK_INVERTED, i, procTable[i].ntraces, addr, Paddr, fault ? XLATE_FAULT : 0);
+	if(miss && sim->prefetch != NULL)
+		prefetchPages(sim, i, IPN);
+}
+
+// open addressing (linear probing) inverted table에서 slot 하나를 비운다.
+// tombstone 없이 뒤따르는 entry들을 당겨와서(backward shift) probe 순서를 유지한다
+static void iptOpenDelete(struct vmSim *sim, unsigned slot) {
+	struct iptSlot *slots = sim->iptSlots;
+	unsigned j = slot, home;
+
+	for(;;) {
+		j = (j + 1) % sim->iptSize;
+		if(slots[j].key == PAGEMAP_EMPTY)
+			break;
+		home = iptHash(sim, (int)(slots[j].key >> PAGEKEY_PIDSHIFT), slots[j].key & ((1ULL << PAGEKEY_PIDSHIFT) - 1));
+		// home이 (slot, j] 구간 밖이면 slot으로 옮겨도 찾을 수 있다
+		if(slot <= j ? (home <= slot || home > j) : (home <= slot && home > j)) {
+			slots[slot] = slots[j];
+			slot = j;
+		}
+	}
+	slots[slot].key = PAGEMAP_EMPTY;
+}
+
+static void iptOpenUnmap(struct vmSim *sim, int frame) {
+	uint64_t key;
+	unsigned slot;
+
+	if(sim->frames.vpn[frame] == -1)
+		return;
+	key = pageKey(sim->frames.pid[frame], sim->frames.vpn[frame]);
+	for(slot = iptHash(sim, sim->frames.pid[frame], sim->frames.vpn[frame]); sim->iptSlots[slot].key != key; slot = (slot + 1) % sim->iptSize)
+		assert(sim->iptSlots[slot].key != PAGEMAP_EMPTY);
+	iptOpenDelete(sim, slot);
+}
+
+// frame에 매핑돼 있던 page를 내보낸다. eviction을 세고 (slow tier가 있으면 그리로 내리고) TLB와 page table에서 지운다
+// (빈 frame이면 아무것도 안 한다). 지운 뒤에도 frame의 pid/vpn은 남아있으므로 frame을 비워두려면 호출한 쪽에서 vpn을 -1로 만든다
+static void unmapFrame(struct vmSim *sim, int frame) {
+	struct procEntry *proc;
+	int64_t vpn = sim->frames.vpn[frame];
+	uint64_t *region;
+
+	if(vpn == -1)
+		return;
+	if(sim->tier != NULL)
+		tierDemote(sim, frame);
+	else
+		countEviction(sim, frame);
+	tlbInvalidate(sim, frame);
+	if(sim->cache != NULL)
+		cacheInvalidate(sim, frame);
+	proc = &sim->procTable[sim->frames.pid[frame]];
+	if(sim->frames.filled != NULL && sim->frames.filled[frame] == FILL_PREFETCH)	// 한 번도 쓰지 않고 내보낸다
+		proc->numPrefetchHarmful++;
+	if(sim->thp != NULL) {
+		region = pageMapGet(sim->thp, pageKey(proc->pid, vpn >> THP_ORDER));
+		if(*region & THP_HUGE) {	// huge page를 base page들로 쪼갠다 (demotion)
+			proc->numDemotion++;
+			if(sim->tlb != NULL)
+				tlbInvalidateKey(sim->tlb, pageKey(proc->pid, vpn >> THP_ORDER) | THP_TLBKEY, vpn >> THP_ORDER);
+		}
+		*region = (*region & THP_COUNT) - 1;
+	}
+	if(sim->type == '0')
+		*oneLevelPTE(proc, vpn) = 0;
+	else if(sim->type == '1')	// fVPN/sVPN은 vpn의 상위/하위 bit
+		proc->firstLevelPageTable[vpn >> sim->twoLevelBits].secondLevelPageTable[vpn & (sim->twoLevelPageTableSize - 1)].valid = '0';
+	else if(sim->type == '4')
+		*sim->frames.pte[frame] = 0;
+	else if(sim->iptSlots != NULL)
+		iptOpenUnmap(sim, frame);
+	else
+		invertedUnmap(sim, frame);
+}
+
+// invertedAccess와 같은 시뮬레이션을 open addressing table로 한다.
+// home slot이 비어있으면 NULL access, 아니면 Non-NULL access이고 살펴본 entry 수를 conflict로 센다
+PAGE_KERNEL void invertedOpenAccess(struct vmSim *sim, int i, unsigned addr, char rw, const int pageBits) {
+	struct procEntry *procTable = sim->procTable;
+	struct iptSlot *slots = sim->iptSlots;
+	int frame, fault = 0, miss = 0;
+	unsigned offset, IPN, slot;
+	uint64_t key, Paddr;
+	int walkRefs = 1;
+
+	IPN = addr >> pageBits;
+	key = pageKey(procTable[i].pid, IPN);
+	slot = iptHash(sim, procTable[i].pid, IPN);
+	offset = addr & ((1u << pageBits) - 1);
+
+	if(slots[slot].key == PAGEMAP_EMPTY)
+		procTable[i].numIHTNULLAccess++;
+	else {
+		procTable[i].numIHTNonNULLAcess++;
+		procTable[i].numIHTConflictAccess++;
+		for(;;) {
+			if(slots[slot].key == key) {	// Page Hit
+				procTable[i].numPageHit++;
+				sim->frames.dirty[slots[slot].frameNumber] |= IS_WRITE(rw);
+				miss = fillTouch(sim, i, slots[slot].frameNumber);
+				sim->policy->hit(sim, slots[slot].frameNumber);
+				Paddr = ((uint64_t)slots[slot].frameNumber << pageBits) + offset;
+				goto translated;
+			}
+			slot = (slot + 1) % sim->iptSize;
+			if(slots[slot].key == PAGEMAP_EMPTY)
+				break;
+			procTable[i].numIHTConflictAccess++;
+			walkRefs++;
+		}
+	}
+
+	// page fault
+	procTable[i].numPageFault++;
+	fault = miss = 1;
+	frame = getFrame(sim, procTable[i].pid, IPN);
+	unmapFrame(sim, frame);
+
+	// 삭제로 entry가 당겨졌을 수 있으므로 home부터 다시 빈 slot을 찾는다
+	for(slot = iptHash(sim, procTable[i].pid, IPN); slots[slot].key != PAGEMAP_EMPTY; slot = (slot + 1) % sim->iptSize)
+		;
+	slots[slot].key = key;
+	slots[slot].frameNumber = frame;
+	mapFrame(sim, frame, procTable[i].pid, IPN, rw);
+
+	Paddr = ((uint64_t)frame << pageBits) + offset;
+
+translated:
+	tlbTranslate(sim, i, IPN, Paddr >> pageBits, walkRefs);
+	procTable[i].ntraces++;
+	if(sim->cache != NULL)
+		cacheAccess(sim, i, Paddr);
+	if(sim->out != NULL)
+		sinkTranslation(sim->out, SINK_INVERTED, i, procTable[i].ntraces, addr, Paddr, fault ? XLATE_FAULT : 0);
+	if(miss && sim->prefetch != NULL)
+		prefetchPages(sim, i, IPN);
+}
+
+// N-level radix page table. 위 level부터 VPN의 bits[l]개 bit로 index해서 내려간다.
+// interior entry는 아래 level table의 주소, 마지막 level의 entry는 frame 번호 + 1 (0이면 invalid)
+PAGE_KERNEL void radixAccess(struct vmSim *sim, int i, uint64_t addr, char rw, const int pageBits) {
+	struct procEntry *procTable = sim->procTable;
+	int frame, fault = 0, miss = 0;
+	uint64_t va, vpn, Paddr, *table, *entry;
+	int l, shift, walkRefs = 0;
+
+	// canonical 주소의 sign extension bit는 버린다
+	va = radixConf.vaBits < 64 ? addr & ((1ULL << radixConf.vaBits) - 1) : addr;
+	vpn = va >> pageBits;
+
+	// 없는 table을 만나거나 마지막 level에 도착할 때까지 내려간다
+	table = procTable[i].radixRoot;
+	shift = radixConf.vaBits - pageBits;
+	for(l = 0; ; l++) {
+		shift -= radixConf.bits[l];
+		entry = &table[(vpn >> shift) & ((1ULL << radixConf.bits[l]) - 1)];
+		walkRefs++;
+		if(*entry == 0 || l == radixConf.levels - 1)
+			break;
+		table = (uint64_t *)(uintptr_t)*entry;
+	}
+
+	// pageHit
+	if(l == radixConf.levels - 1 && *entry != 0) {
+		procTable[i].numPageHit++;
+		frame = *entry - 1;
+		sim->frames.dirty[frame] |= IS_WRITE(rw);
+		miss = fillTouch(sim, i, frame);
+		sim->policy->hit(sim, frame);
+	}
+
+	// pageFault
+	else {
+		procTable[i].numPageFault++;
+		fault = miss = 1;
+
+		frame = getFrame(sim, procTable[i].pid, vpn);
+		unmapFrame(sim, frame);	// table은 two-level처럼 한 번 만들면 해제하지 않는다
+
+		// 없는 아래 level table들은 arena에서 만들면서 내려간다
+		if(l < radixConf.levels - 1)
+			entry = radixLeaf(sim, &procTable[i], vpn, 1);
+		*entry = frame + 1;
+		sim->frames.pte[frame] = entry;
+		mapFrame(sim, frame, procTable[i].pid, vpn, rw);
+	}
+
+	Paddr = ((uint64_t)frame << pageBits) + (va & ((1ULL << pageBits) - 1));
+	tlbTranslate(sim, i, vpn, frame, walkRefs);
+	procTable[i].ntraces++;
+	if(sim->cache != NULL)
+		cacheAccess(sim, i, Paddr);
+	// -s option print statement
+	if(sim->out != NULL)
+		sinkTranslation(sim->out, SINK_RADIX, i, procTable[i].ntraces, addr, Paddr, fault ? XLATE_FAULT : 0);
+	if(miss && sim->prefetch != NULL)
+		prefetchPages(sim, i, vpn);
+	if(fault && sim->thp != NULL)
+		thpPromote(sim, i, vpn);
+}
+
+// 32bit page table들은 주소의 하위 32bit만 쓴다
+PAGE_KERNEL void pageAccess(struct vmSim *sim, int i, uint64_t addr, char rw, const int pageBits) {
+	if(sim->tier != NULL && tierAccess(sim, i, addr, rw))
+		return;
+	if(sim->type == '0')
+		oneLevelAccess(sim, i, (unsigned)addr, rw, pageBits);
+	else if(sim->type == '1')
+		twoLevelAccess(sim, i, (unsigned)addr, rw, pageBits);
+	else if(sim->type == '4')
+		radixAccess(sim, i, addr, rw, pageBits);
+	else if(sim->iptSlots != NULL)
+		invertedOpenAccess(sim, i, (unsigned)addr, rw, pageBits);
+	else
+		invertedAccess(sim, i, (unsigned)addr, rw, pageBits);
+}
+
+// 4K, 2M, 1G page는 page 크기가 상수인 kernel을 쓰고 나머지 크기는 sim->pageBits를 읽는다
+static void accessPage4K(struct vmSim *sim, int i, uint64_t addr, char rw) { pageAccess(sim, i, addr, rw, 12); }
+static void accessPage2M(struct vmSim *sim, int i, uint64_t addr, char rw) { pageAccess(sim, i, addr, rw, 21); }
+static void accessPage1G(struct vmSim *sim, int i, uint64_t addr, char rw) { pageAccess(sim, i, addr, rw, 30); }
+static void accessPageAny(struct vmSim *sim, int i, uint64_t addr, char rw) { pageAccess(sim, i, addr, rw, sim->pageBits); }
+
+static inline void vmSimAccess(struct vmSim *sim, int i, uint64_t addr, char rw) {
+	if(i != sim->lastPid) {		// context switch
+		sim->procTable[i].numContextSwitch++;
+		sim->lastPid = i;
+	}
+	sim->access(sim, i, addr, rw);
+}
+
+// 프로세스 하나의 결과 출력. id는 출력에 쓰는 프로세스 번호. 이 프로세스의 simulated I/O 시간을 돌려준다
+double reportProc(const struct procEntry *proc, int id, char type) {
+	double ioTime;
+	int l;
+
+	printf("**** %s *****\n",proc->traceName);
+	printf("Proc %d Num of traces %lld\n",id,proc->ntraces);
+	if(type == '0')
+		printf("Proc %d Page table resident bytes %llu (%d PTE chunks)\n",id,
+				(unsigned long long)(PTEDIRSIZE * sizeof(pte_t *) + (size_t)proc->numPTEChunk * PTECHUNKSIZE * sizeof(pte_t)),
+				proc->numPTEChunk);
+	if(type == '1')
+		printf("Proc %d Num of second level page tables allocated %d\n",id,proc->num2ndLevelPageTable);
+	if(type == '4')
+		for(l = 0; l < radixConf.levels; l++)
+			printf("Proc %d Num of level %d page tables allocated %d (%llu bytes)\n",id,l+1,proc->numRadixTable[l],
+					(unsigned long long)proc->numRadixTable[l] * (sizeof(uint64_t) << radixConf.bits[l]));
+	if(type == '2') {
+		printf("Proc %d Num of Inverted Hash Table Access Conflicts %lld\n",id,proc->numIHTConflictAccess);
+		printf("Proc %d Num of Empty Inverted Hash Table Access %lld\n",id,proc->numIHTNULLAccess);
+		printf("Proc %d Num of Non-Empty Inverted Hash Table Access %lld\n",id,proc->numIHTNonNULLAcess);
+	}
+	printf("Proc %d Num of Page Faults %lld\n",id,proc->numPageFault);
+	printf("Proc %d Num of Page Hit %lld\n",id,proc->numPageHit);
+	printf("Proc %d Num of context switches %lld\n",id,proc->numContextSwitch);
+	if(thpConf.threshold && (type == '0' || type == '4')) {
+		printf("Proc %d Num of huge page promotions %lld\n",id,proc->numPromotion);
+		printf("Proc %d Num of huge page demotions %lld\n",id,proc->numDemotion);
+		printf("Proc %d Num of base pages filled by promotion %lld\n",id,proc->numPromoteFill);
+		printf("Proc %d Num of page faults avoided by promotion %lld (net %lld page reads)\n",id,proc->numFaultAvoided,
+				proc->numFaultAvoided - proc->numPromoteFill);
+	}
+	if(prefetchConf.kind) {
+		printf("Proc %d Num of prefetches issued %lld\n",id,proc->numPrefetch);
+		printf("Proc %d Num of useful prefetches %lld (accuracy %.2f%%)\n",id,proc->numPrefetchUseful,
+				proc->numPrefetch ? 100.0 * proc->numPrefetchUseful / proc->numPrefetch : 0.0);
+		printf("Proc %d Num of harmful prefetches %lld (evicted before use)\n",id,proc->numPrefetchHarmful);
+	}
+	// fault는 fault를 낸 프로세스가, write-back은 dirty page의 주인 프로세스가 비용을 낸다.
+	// 승격으로 채운 page와 prefetch한 page는 fault 없이 읽어온다
+	ioTime = proc->numPageFault * cost.faultService + (proc->numPromoteFill + proc->numPrefetch) * cost.fillRead
+			+ proc->numDirtyEviction * cost.writeBack;
+	printf("Proc %d Num of Clean Evictions %lld\n",id,proc->numCleanEviction);
+	printf("Proc %d Num of Dirty Evictions %lld\n",id,proc->numDirtyEviction);
+	printf("Proc %d Simulated I/O time %.3f ms\n",id,ioTime / 1e6);
+	printf("Proc %d Effective memory access time %.1f ns\n",id,
+			proc->ntraces ? cost.memAccess + ioTime / proc->ntraces : 0.0);
+	if(tierConf.frames) {
+		// slow tier hit은 (올리든 말든) 그 access를 slow tier에서 읽고, 나머지는 fast tier에서 읽는다. fault는 I/O를 더한다
+		printf("Proc %d Fast tier hit rate %.4f, slow tier hit rate %.4f (%lld hits), fault rate %.4f\n",id,
+				proc->ntraces ? (double)proc->numPageHit / proc->ntraces : 0.0,
+				proc->ntraces ? (double)proc->numSlowHit / proc->ntraces : 0.0, proc->numSlowHit,
+				proc->ntraces ? (double)proc->numPageFault / proc->ntraces : 0.0);
+		printf("Proc %d Num of promotions to the fast tier %lld\n",id,proc->numTierPromotion);
+		printf("Proc %d Num of demotions to the slow tier %lld\n",id,proc->numTierDemotion);
+		printf("Proc %d Average memory access time %.1f ns\n",id,
+				proc->ntraces ? ((proc->ntraces - proc->numSlowHit) * cost.memAccess + proc->numSlowHit * tierConf.slowNs + ioTime)
+				/ proc->ntraces : 0.0);
+	}
+	if(cacheConf.bytes) {
+		printf("Proc %d Num of cache hits %lld, misses %lld (miss rate %.4f)\n",id,proc->numCacheHit,proc->numCacheMiss,
+				proc->ntraces ? (double)proc->numCacheMiss / proc->ntraces : 0.0);
+		printf("Proc %d Num of cache conflict misses %lld (%.2f%% of misses)\n",id,proc->numCacheConflict,
+				proc->numCacheMiss ? 100.0 * proc->numCacheConflict / proc->numCacheMiss : 0.0);
+		assert(proc->numCacheHit + proc->numCacheMiss == proc->ntraces);
+	}
+	if(tlbConf.entries > 0) {
+		// walk 한 번의 비용은 page table memory reference 수 * memory access 시간
+		printf("Proc %d Num of TLB Hit %lld\n",id,proc->numTLBHit);
+		printf("Proc %d Num of TLB Miss %lld\n",id,proc->numTLBMiss);
+		printf("Proc %d Page table memory references per walk %.2f\n",id,
+				proc->numTLBMiss ? (double)proc->numPTWalkRef / proc->numTLBMiss : 0.0);
+		printf("Proc %d Average translation latency %.2f ns\n",id,
+				proc->ntraces ? tlbConf.hitNs + proc->numPTWalkRef * cost.memAccess / proc->ntraces : 0.0);
+		printf("Proc %d TLB misses per context switch %.2f\n",id,
+				proc->numContextSwitch ? (double)proc->numTLBMiss / proc->numContextSwitch : 0.0);
+		assert(proc->numTLBHit + proc->numTLBMiss == proc->ntraces);
+	}
+	assert(proc->numPageHit + proc->numPageFault + proc->numSlowHit == proc->ntraces);
+	if(type == '2')
+		assert(proc->numIHTNULLAccess + proc->numIHTNonNULLAcess + proc->numSlowHit == proc->ntraces);
+	return ioTime;
+}
+
+void reportVMSim(struct vmSim *sim) {
+	struct procEntry *procTable = sim->procTable;
+	double totalIoTime = 0;
+	long long totalDirty = 0, totalTraces = 0;
+	int i, l;
+
+	if(sim->out != NULL)
+		sinkFlush(sim->out);
+	for(i=0; i < sim->nProc; i++) {
+		totalIoTime += reportProc(&procTable[i], i, sim->type);
+		totalDirty += procTable[i].numDirtyEviction;
+		totalTraces += procTable[i].ntraces;
+	}
+	if(sim->policy->report != NULL)
+		sim->policy->report(sim);
+	printf("Total Num of Dirty Evictions %lld Simulated I/O time %.3f ms Effective memory access time %.1f ns\n",
+			totalDirty, totalIoTime / 1e6, totalTraces ? cost.memAccess + totalIoTime / totalTraces : 0.0);
+	if(sim->type == '4') {
+		printf("Radix page table %d-bit virtual address, bits per level", radixConf.vaBits);
+		for(l = 0; l < radixConf.levels; l++)
+			printf(" %d", radixConf.bits[l]);
+		printf(", %llu bytes of tables\n", (unsigned long long)sim->tableArena.bytes);
+	}
+	if(sim->type == '2' && iptConf.set)
+		printf("Inverted table %s, %s hash, %d slots, load factor %.2f\n",
+				sim->iptSlots != NULL ? "open addressing" : "chained",
+				sim->iptHash == 'm' ? "(vpn + pid) % size" : sim->iptHash == 'x' ? "mix64" : "Fibonacci",
+				sim->iptSize, (double)sim->nUsedFrame / sim->iptSize);
+	if(sim->prefetch != NULL)
+		printf("Prefetcher %s, degree %d\n", prefetchConf.kind == 'n' ? "next-N pages" : prefetchConf.kind == 's' ? "stride" : "Markov",
+				prefetchConf.degree);
+	if(sim->cache != NULL) {
+		printf("Cache %d bytes %d-way, %d-byte lines, %d sets, %d page colors", cacheConf.bytes, sim->cache->ways,
+				1 << sim->cache->lineBits, sim->cache->sets, sim->cache->colors);
+		if(cacheConf.coloring && sim->colors <= 1)
+			printf(", no page coloring (the cache way is not larger than a page)");
+		else if(cacheConf.coloring && sim->policy->victim != listVictim)
+			printf(", no page coloring (not FIFO or LRU)");
+		else if(cacheConf.coloring)
+			printf(", page coloring matched %lld of %lld victims (%.2f%%)", sim->cache->numColorVictim, sim->cache->numVictim,
+					sim->cache->numVictim ? 100.0 * sim->cache->numColorVictim / sim->cache->numVictim : 0.0);
+		printf("\n");
+	}
+	if(sim->tier != NULL)
+		printf("Slow tier %d frames, %d in use\n", tierConf.frames, tierConf.frames - sim->tier->nFree);
+	if(sim->tlb != NULL)
+		printf("TLB %d entries %d-way %s, %s, %lld flushes\n", tlbConf.entries, tlbConf.ways,
+				tlbConf.policy == 'L' ? "LRU" : tlbConf.policy == 'F' ? "FIFO" : "random",
+				tlbConf.asid ? "ASID tagged" : "flush on process switch", sim->tlb->numFlush);
+}
+
+// library interface (memsim.h). trace 파일 없이 access를 하나씩 넣는다
+struct vmSim *vmSimCreate(const struct vmSimConfig *conf) {
+	struct procEntry *procTable;
+	struct vmSim *sim;
+	int i;
+
+	if(conf->nProc < 1 || conf->nFrame < 1 || conf->nFrame > (1 << MAXFRAMEBITS) || strchr("0124", conf->type) == NULL
+			|| conf->type == '\0' || conf->policy == 'O' || findPolicy(conf->policy) == NULL
+			|| conf->pageBits < PAGESIZEBITS || conf->pageBits > MAXPAGESIZEBITS
+			|| (conf->type == '4' && conf->pageBits != pageSizeBits)	// radixConf는 -P의 page 크기로 나눠져 있다
+			|| (conf->type == '1' && (conf->firstLevelBits < 1 || VIRTUALADDRBITS - conf->pageBits - conf->firstLevelBits <= 0)))
+		return NULL;
+
+	procTable = (struct procEntry *)calloc(conf->nProc, sizeof(struct procEntry));
+	for(i = 0; i < conf->nProc; i++)
+		procTable[i].traceName = "(embedded)";
+	sim = (struct vmSim *)malloc(sizeof(struct vmSim));
+	initVMSimBits(sim, conf->type, conf->policy, procTable, conf->nProc, conf->nFrame, conf->pageBits,
+			conf->type == '1' ? conf->firstLevelBits : 1);
+	if(conf->verbose && sim->out == NULL)
+		sim->out = sinkOpen();
+	free(procTable);
+	return sim;
+}
+
+void vmSimStep(struct vmSim *sim, int pid, uint64_t addr, char rw) {
+	assert(pid >= 0 && pid < sim->nProc);
+	vmSimAccess(sim, pid, addr, rw);
+}
+
+void vmSimStepBatch(struct vmSim *sim, int pid, const uint64_t *addrs, const char *rws, int n) {
+	int j;
+
+	assert(pid >= 0 && pid < sim->nProc);
+	for(j = 0; j < n; j++)
+		vmSimAccess(sim, pid, addrs[j], rws[j]);
+}
+
+int vmSimGetStats(struct vmSim *sim, int pid, struct vmSimStats *stats) {
+	const struct procEntry *proc;
+
+	if(pid < 0 || pid >= sim->nProc)
+		return -1;
+	proc = &sim->procTable[pid];
+	stats->ntraces = proc->ntraces;
+	stats->numPageFault = proc->numPageFault;
+	stats->numPageHit = proc->numPageHit;
+	stats->numSlowHit = proc->numSlowHit;
+	stats->numCleanEviction = proc->numCleanEviction;
+	stats->numDirtyEviction = proc->numDirtyEviction;
+	stats->numTLBHit = proc->numTLBHit;
+	stats->numTLBMiss = proc->numTLBMiss;
+	return 0;
+}
+
+void vmSimReport(struct vmSim *sim) {
+	reportVMSim(sim);
+}
+
+void vmSimDestroy(struct vmSim *sim) {
+	freeVMSim(sim);
+	free(sim);
+}
+
+// reader thread가 채우는 프로세스별 single producer / single consumer ring. lock 없이 head, tail만 atomic으로 주고받는다.
+// producer는 slot tail % depth를 채운 뒤 tail을, consumer는 slot head % depth를 다 쓴 뒤 head를 늘린다
+struct ingestRing {
+	_Atomic uint64_t tail __attribute__((aligned(64)));	// producer가 채운 batch 수
+	atomic_int eof;				// producer가 trace의 끝까지 읽었음 (마지막 tail 뒤에 쓴다)
+	_Atomic uint64_t head __attribute__((aligned(64)));	// consumer가 다 쓴 batch 수
+	int pos;					// consumer: slot head에서 다음에 꺼낼 record
+	long long consumerStall;	// consumer가 빈 ring을 기다린 횟수
+	int *n __attribute__((aligned(64)));	// slot별 record 수
+	uint64_t *addr, *time;		// slot s의 record는 [s * batch, (s + 1) * batch)
+	char *rw;
+	int full;					// producer: ring이 찬 것을 이미 셌음
+	int done;					// producer: trace의 끝
+	long long producerStall;	// producer가 찬 ring 때문에 기다린 횟수
+	long long batches;			// 채운 batch 수
+};
+
+struct ingest {
+	struct procEntry *procTable;
+	struct ingestRing *rings;
+	int nProc, readers, depth, batch;
+	atomic_int stop;			// consumer가 끝까지 읽지 않고 그만둠
+	pthread_t *threads;
+	struct ingestReader *args;
+};
+
+struct ingestReader {
+	struct ingest *in;
+	int id;						// 프로세스 id, id + readers, ... 를 맡는다
+};
+
+void *ingestReaderMain(void *arg) {
+	struct ingestReader *reader = (struct ingestReader *)arg;
+	struct ingest *in = reader->in;
+	struct ingestRing *r;
+	struct traceFile *trace;
+	uint64_t tail, base;
+	int i, n, active, progress;
+
+	for(;;) {
+		active = progress = 0;
+		for(i = reader->id; i < in->nProc; i += in->readers) {
+			r = &in->rings[i];
+			if(r->done)
+				continue;
+			active = 1;
+			tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+			if(tail - atomic_load_explicit(&r->head, memory_order_acquire) == (uint64_t)in->depth) {
+				if(!r->full)
+					r->producerStall++;
+				r->full = 1;
+				continue;
+			}
+			r->full = 0;
+			trace = &in->procTable[i].trace;
+			base = (tail % in->depth) * in->batch;
+			for(n = 0; n < in->batch && readTrace(trace, &r->addr[base + n], &r->rw[base + n]) != EOF; n++)
+				r->time[base + n] = trace->time;
+			r->n[tail % in->depth] = n;
+			if(n > 0) {
+				atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+				r->batches++;
+			}
+			if(n < in->batch) {
+				r->done = 1;
+				atomic_store_explicit(&r->eof, 1, memory_order_release);
+			}
+			progress = 1;
+		}
+		if(!active || atomic_load_explicit(&in->stop, memory_order_relaxed))
+			break;
+		if(!progress)	// 맡은 ring이 모두 찼다
+			sched_yield();
+	}
+	return NULL;
+}
+
+struct ingest *startIngest(struct procEntry *procTable, int nProc) {
+	struct ingest *in = (struct ingest *)malloc(sizeof(struct ingest));
+	size_t slots = (size_t)ingestConf.depth * ingestConf.batch;
+	int i;
+
+	in->procTable = procTable;
+	in->nProc = nProc;
+	in->readers = ingestConf.readers < nProc ? ingestConf.readers : nProc;
+	in->depth = ingestConf.depth;
+	in->batch = ingestConf.batch;
+	atomic_init(&in->stop, 0);
+	in->rings = (struct ingestRing *)aligned_alloc(64, sizeof(struct ingestRing) * nProc);
+	for(i = 0; i < nProc; i++) {
+		struct ingestRing *r = &in->rings[i];
+		atomic_init(&r->tail, 0);
+		atomic_init(&r->head, 0);
+		atomic_init(&r->eof, 0);
+		r->pos = 0;
+		r->n = (int *)malloc(sizeof(int) * in->depth);
+		r->addr = (uint64_t *)malloc(sizeof(uint64_t) * slots);
+		r->time = (uint64_t *)malloc(sizeof(uint64_t) * slots);
+		r->rw = (char *)malloc(slots);
+		r->full = r->done = 0;
+		r->producerStall = r->consumerStall = r->batches = 0;
+	}
+	in->threads = (pthread_t *)malloc(sizeof(pthread_t) * in->readers);
+	in->args = (struct ingestReader *)malloc(sizeof(struct ingestReader) * in->readers);
+	for(i = 0; i < in->readers; i++) {
+		in->args[i].in = in;
+		in->args[i].id = i;
+		if(pthread_create(&in->threads[i], NULL, ingestReaderMain, &in->args[i]) != 0) {
+			printf("pthread_create failed\n"); exit(1);
+		}
+	}
+	return in;
+}
+
+// 프로세스 i의 record를 최대 max개 꺼낸다. trace의 끝에서만 max보다 적게 돌려준다. times가 NULL이면 timestamp는 버린다
+int ingestRead(struct ingest *in, int i, uint64_t *addrs, char *rws, uint64_t *times, int max) {
+	struct ingestRing *r = &in->rings[i];
+	uint64_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+	int n = 0, k, waited = 0;
+	size_t base;
+
+	while(n < max) {
+		if(head == atomic_load_explicit(&r->tail, memory_order_acquire)) {
+			// eof를 본 뒤 tail을 다시 읽어야 마지막 batch를 놓치지 않는다
+			if(atomic_load_explicit(&r->eof, memory_order_acquire) && head == atomic_load_explicit(&r->tail, memory_order_acquire))
+				break;
+			if(!waited)
+				r->consumerStall++;
+			waited = 1;
+			sched_yield();
+			continue;
+		}
+		waited = 0;
+		base = (head % in->depth) * in->batch;
+		k = r->n[head % in->depth] - r->pos;
+		if(k > max - n)
+			k = max - n;
+		memcpy(&addrs[n], &r->addr[base + r->pos], sizeof(uint64_t) * k);
+		memcpy(&rws[n], &r->rw[base + r->pos], k);
+		if(times != NULL)
+			memcpy(&times[n], &r->time[base + r->pos], sizeof(uint64_t) * k);
+		n += k;
+		r->pos += k;
+		if(r->pos == r->n[head % in->depth]) {	// slot을 다 썼으므로 producer에게 돌려준다
+			r->pos = 0;
+			atomic_store_explicit(&r->head, ++head, memory_order_release);
+		}
+	}
+	return n;
+}
+
+// reader thread들을 멈추고 프로세스별 stall 수를 출력한다
+void stopIngest(struct ingest *in) {
+	int i;
+
+	atomic_store_explicit(&in->stop, 1, memory_order_relaxed);
+	for(i = 0; i < in->readers; i++)
+		pthread_join(in->threads[i], NULL);
+
+	printf("Ingest %d reader threads, ring depth %d batches of %d accesses\n", in->readers, in->depth, in->batch);
+	for(i = 0; i < in->nProc; i++) {
+		struct ingestRing *r = &in->rings[i];
+		printf("Ingest proc %d %lld batches, producer stalls %lld (ring full), consumer stalls %lld (ring empty)\n",
+				i, r->batches, r->producerStall, r->consumerStall);
+		free(r->n);
+		free(r->addr);
+		free(r->time);
+		free(r->rw);
+	}
+	free(in->rings);
+	free(in->threads);
+	free(in->args);
+	free(in);
+}
+
+// trace들을 하나의 access stream으로 합친다 (-Q).
+// round-robin은 프로세스마다 quantum * weight개씩 돌아가며 읽고 먼저 끝난 프로세스는 건너뛴다.
+// timestamp 모드는 trace마다 다음 record를 미리 읽어두고 (timestamp, pid)가 가장 작은 것을 heap으로 고른다
+struct scheduler {
+	struct procEntry *procTable;	// trace를 가진 procTable
+	int cur;					// round-robin: 지금 차례인 프로세스
+	int left;					// round-robin: cur의 quantum에서 남은 access 수
+	int eof_cnt;				// 끝난 프로세스의 개수
+	int *heap;					// timestamp: 다음 record가 남은 프로세스들
+	int heapSize;
+	uint64_t *nextAddr, *nextTime;	// timestamp: 프로세스별로 미리 읽은 record
+	char *nextRw;
+	struct ingest *ingest;		// -D: reader thread들이 채우는 ring. NULL이면 trace를 직접 읽는다
+};
+
+#define SCHED_BATCH 4096		// readScheduleBatch로 한 번에 읽는 access 수
+
+static inline int schedQuantum(int i) {
+	return schedConf.weight != NULL ? schedConf.quantum * schedConf.weight[i] : schedConf.quantum;
+}
+
+static inline int schedLess(struct scheduler *s, int a, int b) {
+	return s->nextTime[a] != s->nextTime[b] ? s->nextTime[a] < s->nextTime[b] : a < b;
+}
+
+static void schedSiftDown(struct scheduler *s, int k) {
+	int child, t;
+
+	for(;;) {
+		child = 2 * k + 1;
+		if(child >= s->heapSize)
+			break;
+		if(child + 1 < s->heapSize && schedLess(s, s->heap[child + 1], s->heap[child]))
+			child++;
+		if(!schedLess(s, s->heap[child], s->heap[k]))
+			break;
+		t = s->heap[k];
+		s->heap[k] = s->heap[child];
+		s->heap[child] = t;
+		k = child;
+	}
+}
+
+// 프로세스 i의 다음 record를 미리 읽는다. 끝났으면 0
+static int schedLookahead(struct scheduler *s, int i) {
+	if(s->ingest != NULL ? ingestRead(s->ingest, i, &s->nextAddr[i], &s->nextRw[i], &s->nextTime[i], 1) == 0
+			: readTrace(&s->procTable[i].trace, &s->nextAddr[i], &s->nextRw[i]) == EOF) {
+		s->procTable[i].eof_valid = 1;
+		s->eof_cnt++;
+		return 0;
+	}
+	if(s->ingest == NULL)
+		s->nextTime[i] = s->procTable[i].trace.time;
+	return 1;
+}
+
+void initScheduler(struct scheduler *s, struct procEntry *procTable) {
+	int i;
+
+	s->procTable = procTable;
+	s->cur = numProcess - 1;	// 처음 읽을 때 0번으로 넘어간다
+	s->left = 0;
+	s->eof_cnt = 0;
+	s->heap = NULL;
+	s->heapSize = 0;
+	s->nextAddr = s->nextTime = NULL;
+	s->nextRw = NULL;
+	s->ingest = ingestConf.readers ? startIngest(procTable, numProcess) : NULL;
+	for(i = 0; i < numProcess; i++)
+		procTable[i].eof_valid = 0;
+
+	if(schedConf.mode == 't') {
+		s->heap = (int *)calloc((unsigned)numProcess, sizeof(int));
+		s->nextAddr = (uint64_t *)calloc((unsigned)numProcess, sizeof(uint64_t));
+		s->nextTime = (uint64_t *)calloc((unsigned)numProcess, sizeof(uint64_t));
+		s->nextRw = (char *)calloc((unsigned)numProcess, 1);
+		for(i = 0; i < numProcess; i++)
+			if(schedLookahead(s, i))
+				s->heap[s->heapSize++] = i;
+		for(i = s->heapSize / 2 - 1; i >= 0; i--)
+			schedSiftDown(s, i);
+	}
+}
+
+void freeScheduler(struct scheduler *s) {
+	if(s->ingest != NULL)
+		stopIngest(s->ingest);
+	free(s->heap);
+	free(s->nextAddr);
+	free(s->nextTime);
+	free(s->nextRw);
+}
+
+// 한 프로세스(*pid)의 연속된 access를 최대 max개 읽는다. 모든 trace가 끝나면 0.
+// round-robin은 quantum이 끝날 때까지, timestamp 모드는 다른 trace의 다음 record보다 늦어질 때까지 같은 프로세스를 읽는다
+int readScheduleBatch(struct scheduler *s, int *pid, uint64_t *addrs, char *rws, int max) {
+	int i, n, want;
+
+	if(schedConf.mode == 't') {
+		if(s->heapSize == 0)
+			return 0;
+		i = s->heap[0];
+		for(n = 0; n < max && s->heap[0] == i; ) {
+			addrs[n] = s->nextAddr[i];
+			rws[n++] = s->nextRw[i];
+			if(!schedLookahead(s, i))
+				s->heap[0] = s->heap[--s->heapSize];
+			schedSiftDown(s, 0);
+			if(s->heapSize == 0)
+				break;
+		}
+		*pid = i;
+		return n;
+	}
+
+	while(s->eof_cnt != numProcess) {	// 프로세스의 개수만큼 eof를 읽으면 종료.
+		if(s->left == 0) {	// 다음 프로세스 차례. 먼저 끝난 프로세스는 건너뛴다
+			do
+				s->cur = (s->cur + 1 == numProcess) ? 0 : s->cur + 1;
+			while(s->procTable[s->cur].eof_valid == 1);
+			s->left = schedQuantum(s->cur);
+		}
+		want = max < s->left ? max : s->left;
+		if(s->ingest != NULL)
+			n = ingestRead(s->ingest, s->cur, addrs, rws, NULL, want);
+		else
+			n = readTraceBatch(&s->procTable[s->cur].trace, addrs, rws, want);
+		if(n < want) {	// 파일의 끝
+			s->procTable[s->cur].eof_valid = 1;
+			s->eof_cnt++;
+			s->left = 0;
+			if(n == 0)
+				continue;
+		}
+		else
+			s->left -= n;
+		*pid = s->cur;
+		return n;
+	}
+	return 0;
+}
+
+// access 하나 읽기. 모든 trace가 끝나면 EOF
+static inline int readSchedule(struct scheduler *s, int *pid, uint64_t *addr, char *rw) {
+	return readScheduleBatch(s, pid, addr, rw, 1) == 1 ? 2 : EOF;
+}
+
+#define OPT_CHUNK (1 << 20)		// next-use를 거꾸로 계산하는 단위 (access 수)
+
+// OPT를 위한 next-use index를 만든다. scheduler가 만드는 access stream의 j번째 access마다
+// 같은 (pid, VPN)이 다음에 access되는 위치를 uint64로 써둔다 (없으면 OPT_NEVER). VPN은 type의 시뮬레이터가 보는 simPage()
+// 1) stream을 한 번 읽어 page key를 임시 파일에 쓰고 2) 파일을 chunk 단위로 뒤에서부터 읽으며
+// 각 page의 마지막으로 본 위치로 next-use를 구해 index 파일의 같은 위치에 쓴다.
+// 메모리는 chunk 2개와 distinct page 수만큼의 hash만 쓰므로 trace가 RAM보다 커도 된다.
+int buildNextUseIndex(struct procEntry *procTable, char type, char *indexName, size_t nameSize) {
+	struct scheduler sched;
+	struct pageMap lastSeen;
+	char keyName[4096];
+	const char *tmpdir = getenv("TMPDIR");
+	uint64_t *keys, *next, n = 0, start, j, *seen;
+	FILE *keyFile;
+	int keyFd, indexFd, pid, inserted;
+	size_t len, k;
+	uint64_t addr;
+	char rw;
+
+	if(tmpdir == NULL)
+		tmpdir = "/tmp";
+	snprintf(keyName, sizeof(keyName), "%s/memsim-keys-XXXXXX", tmpdir);
+	snprintf(indexName, nameSize, "%s/memsim-nextuse-XXXXXX", tmpdir);
+	if((keyFd = mkstemp(keyName)) < 0)
+		return -1;
+	unlink(keyName);
+	if((indexFd = mkstemp(indexName)) < 0) {
+		close(keyFd);
+		return -1;
+	}
+
+	keys = (uint64_t *)malloc(sizeof(uint64_t) * OPT_CHUNK);
+	next = (uint64_t *)malloc(sizeof(uint64_t) * OPT_CHUNK);
+
+	// 1) page key를 access 순서대로 쓴다
+	keyFile = fdopen(keyFd, "w+b");
+	initScheduler(&sched, procTable);
+	len = 0;
+	while(readSchedule(&sched, &pid, &addr, &rw) != EOF) {
+		keys[len++] = pageKey(pid, simPage(type, addr));
+		if(len == OPT_CHUNK) {
+			fwrite(keys, sizeof(uint64_t), len, keyFile);
+			len = 0;
+		}
+		n++;
+	}
+	fwrite(keys, sizeof(uint64_t), len, keyFile);
+	fflush(keyFile);
+	freeScheduler(&sched);
+	for(pid = 0; pid < numProcess; pid++)
+		rewindTrace(&procTable[pid].trace);
+
+	// 2) 뒤에서부터 chunk 단위로 next-use 계산
+	pageMapInit(&lastSeen, 1 << 16);
+	for(start = n - n % OPT_CHUNK; ; start -= OPT_CHUNK) {
+		len = (n - start < OPT_CHUNK) ? n - start : OPT_CHUNK;
+		if(len > 0) {
+			if(pread(keyFd, keys, len * sizeof(uint64_t), start * sizeof(uint64_t)) != (ssize_t)(len * sizeof(uint64_t)))
+				break;
+			for(k = len; k-- > 0; ) {
+				j = start + k;
+				seen = pageMapPut(&lastSeen, keys[k], OPT_NEVER, &inserted);
+				next[k] = *seen;
+				*seen = j;
+			}
+			if(pwrite(indexFd, next, len * sizeof(uint64_t), start * sizeof(uint64_t)) != (ssize_t)(len * sizeof(uint64_t)))
+				break;
+		}
+		if(start == 0)
+			break;
+	}
+
+	printf("OPT next-use index: %llu accesses, %llu distinct pages, %llu bytes on disk\n",
+			(unsigned long long)n, (unsigned long long)lastSeen.count, (unsigned long long)(n * sizeof(uint64_t)));
+
+	pageMapFree(&lastSeen);
+	free(keys);
+	free(next);
+	fclose(keyFile);
+	close(indexFd);
+	if(start != 0) {	// 쓰기 실패
+		unlink(indexName);
+		return -1;
+	}
+	return 0;
+}
+
+// procTable의 trace를 처음부터 읽으면서 시뮬레이션하고 결과를 출력한다
+void runVMSim(struct vmSim *sim, struct procEntry *procTable) {
+	struct scheduler sched;
+	uint64_t addrs[SCHED_BATCH];
+	char rws[SCHED_BATCH];
+	int i, j, n;
+
+	// 한 번에 같은 프로세스의 access를 묶어서 읽는다
+	initScheduler(&sched, procTable);
+	while((n = readScheduleBatch(&sched, &i, addrs, rws, SCHED_BATCH)) > 0)
+		for(j = 0; j < n; j++)
+			vmSimAccess(sim, i, addrs[j], rws[j]);
+	freeScheduler(&sched);
+
+	reportVMSim(sim);
+
+	for(i=0; i < numProcess; i++)
+		rewindTrace(&procTable[i].trace);
+}
+
+#define FANOUT_BATCH 65536		// 한 번에 넘겨주는 access 개수
+#define FANOUT_SLOTS 8			// decode해둘 수 있는 batch 개수
+
+struct accessBatch {
+	int n;
+	int pid[FANOUT_BATCH];
+	uint64_t addr[FANOUT_BATCH];
+	char rw[FANOUT_BATCH];
+};
+
+// trace를 한 번만 decode해서 여러 시뮬레이터 thread에 나눠준다
+struct fanout {
+	pthread_mutex_t lock;
+	pthread_cond_t producedCond;	// 새 batch가 생겼거나 끝남
+	pthread_cond_t consumedCond;	// 어떤 시뮬레이터가 batch를 다 썼음
+	struct accessBatch *slots;
+	long produced;				// decode한 batch 개수
+	long *consumed;				// 시뮬레이터별로 처리한 batch 개수
+	int nsims;
+	int done;
+};
+
+struct fanoutWorker {
+	struct fanout *f;
+	struct vmSim *sim;
+	int id;
+};
+
+void *fanoutWorkerMain(void *arg) {
+	struct fanoutWorker *w = (struct fanoutWorker *)arg;
+	struct fanout *f = w->f;
+	struct accessBatch *batch;
+	long k = 0;
+	int j;
+
+	for(;;) {
+		pthread_mutex_lock(&f->lock);
+		while(k == f->produced && !f->done)
+			pthread_cond_wait(&f->producedCond, &f->lock);
+		if(k == f->produced) {	// 더 이상 batch가 없음
+			pthread_mutex_unlock(&f->lock);
+			break;
+		}
+		pthread_mutex_unlock(&f->lock);
+
+		batch = &f->slots[k % FANOUT_SLOTS];
+		for(j = 0; j < batch->n; j++)
+			vmSimAccess(w->sim, batch->pid[j], batch->addr[j], batch->rw[j]);
+
+		pthread_mutex_lock(&f->lock);
+		f->consumed[w->id] = ++k;
+		pthread_cond_signal(&f->consumedCond);
+		pthread_mutex_unlock(&f->lock);
+	}
+	return NULL;
+}
+
+// 모든 시뮬레이터가 다 쓴 batch 개수
+static long fanoutMinConsumed(struct fanout *f) {
+	long min = f->produced;
+	int i;
+	for(i = 0; i < f->nsims; i++)
+		if(f->consumed[i] < min)
+			min = f->consumed[i];
+	return min;
+}
+
+// trace를 한 번 decode하면서 sims를 각각의 thread에서 동시에 돌린다. 결과는 순서대로 출력
+void runVMSimsParallel(struct vmSim *sims, int nsims, struct procEntry *procTable) {
+	struct fanout f;
+	struct fanoutWorker *workers;
+	pthread_t *threads;
+	struct accessBatch *batch;
+	struct scheduler sched;
+	int i, j, n, pid, eof = 0;
+
+	pthread_mutex_init(&f.lock, NULL);
+	pthread_cond_init(&f.producedCond, NULL);
+	pthread_cond_init(&f.consumedCond, NULL);
+	f.slots = (struct accessBatch *)malloc(sizeof(struct accessBatch) * FANOUT_SLOTS);
+	f.consumed = (long *)calloc(nsims, sizeof(long));
+	f.produced = 0;
+	f.nsims = nsims;
+	f.done = 0;
+
+	workers = (struct fanoutWorker *)malloc(sizeof(struct fanoutWorker) * nsims);
+	threads = (pthread_t *)malloc(sizeof(pthread_t) * nsims);
+	for(i = 0; i < nsims; i++) {
+		workers[i].f = &f;
+		workers[i].sim = &sims[i];
+		workers[i].id = i;
+		if(pthread_create(&threads[i], NULL, fanoutWorkerMain, &workers[i]) != 0) {
+			printf("pthread_create failed\n"); exit(1);
+		}
+	}
+
+	initScheduler(&sched, procTable);
+	while(!eof) {
+		// 가장 느린 시뮬레이터가 slot을 비울 때까지 기다린다
+		pthread_mutex_lock(&f.lock);
+		while(f.produced - fanoutMinConsumed(&f) == FANOUT_SLOTS)
+			pthread_cond_wait(&f.consumedCond, &f.lock);
+		pthread_mutex_unlock(&f.lock);
+
+		batch = &f.slots[f.produced % FANOUT_SLOTS];
+		for(batch->n = 0; batch->n < FANOUT_BATCH; batch->n += n) {
+			n = readScheduleBatch(&sched, &pid, &batch->addr[batch->n], &batch->rw[batch->n], FANOUT_BATCH - batch->n);
+			if(n == 0) {
+				eof = 1;
+				break;
+			}
+			for(j = batch->n; j < batch->n + n; j++)
+				batch->pid[j] = pid;
+		}
+
+		pthread_mutex_lock(&f.lock);
+		if(batch->n > 0)
+			f.produced++;
+		f.done = eof;
+		pthread_cond_broadcast(&f.producedCond);
+		pthread_mutex_unlock(&f.lock);
+	}
+
+	for(i = 0; i < nsims; i++)
+		pthread_join(threads[i], NULL);
+	freeScheduler(&sched);
+
+	for(i = 0; i < nsims; i++) {
+		printf("=============================================================\n");
+		printf("%s\n", vmSimTitle(&sims[i]));
+		printf("=============================================================\n");
+		reportVMSim(&sims[i]);
+	}
+
+	for(i = 0; i < numProcess; i++)
+		rewindTrace(&procTable[i].trace);
+
+	pthread_cond_destroy(&f.producedCond);
+	pthread_cond_destroy(&f.consumedCond);
+	pthread_mutex_destroy(&f.lock);
+	free(threads);
+	free(workers);
+	free(f.consumed);
+	free(f.slots);
+}
+
+// sims를 차례대로 실행. trace는 시뮬레이션마다 다시 읽는다
+void runVMSims(struct vmSim *sims, int nsims, struct procEntry *procTable) {
+	int i;
+	for(i = 0; i < nsims; i++) {
+		printf("=============================================================\n");
+		printf("%s\n", vmSimTitle(&sims[i]));
+		printf("=============================================================\n");
+		runVMSim(&sims[i], procTable);
+	}
+}
+
+// work stealing thread pool. task는 비용이 큰 것부터 worker들의 deque에 돌아가며 나눠두고,
+// worker는 자기 deque의 앞에서 꺼내다가 비면 다른 worker deque의 뒤(작은 task)에서 훔친다
+struct taskDeque {
+	pthread_mutex_t lock;
+	int *task;
+	int head, tail;				// [head, tail)가 남은 task
+};
+
+struct taskPool {
+	struct taskDeque *deques;
+	int nworkers;
+	void (*run)(void *arg, int task);
+	void *arg;
+};
+
+struct poolWorker {
+	struct taskPool *pool;
+	int id;
+};
+
+struct taskCost {
+	uint64_t cost;
+	int task;
+};
+
+static int taskCostCompare(const void *a, const void *b) {
+	const struct taskCost *x = (const struct taskCost *)a, *y = (const struct taskCost *)b;
+	if(x->cost != y->cost)
+		return x->cost < y->cost ? 1 : -1;
+	return x->task - y->task;
+}
+
+// 다음에 할 task. 모든 deque가 비었으면 -1 (task는 처음에 다 넣어두므로 더 생기지 않는다)
+static int poolNextTask(struct taskPool *pool, int id) {
+	struct taskDeque *d = &pool->deques[id];
+	int k, task = -1;
+
+	pthread_mutex_lock(&d->lock);
+	if(d->head < d->tail)
+		task = d->task[d->head++];
+	pthread_mutex_unlock(&d->lock);
+
+	for(k = 1; task < 0 && k < pool->nworkers; k++) {
+		d = &pool->deques[(id + k) % pool->nworkers];
+		pthread_mutex_lock(&d->lock);
+		if(d->head < d->tail)
+			task = d->task[--d->tail];
+		pthread_mutex_unlock(&d->lock);
+	}
+	return task;
+}
+
+void *poolWorkerMain(void *arg) {
+	struct poolWorker *w = (struct poolWorker *)arg;
+	int task;
+
+	while((task = poolNextTask(w->pool, w->id)) >= 0)
+		w->pool->run(w->pool->arg, task);
+	return NULL;
+}
+
+// task 0 ~ ntasks-1을 CPU 개수만큼의 thread에서 run(arg, task)로 실행한다. work는 task별 예상 비용
+void runTaskPool(int ntasks, const uint64_t *work, void (*run)(void *arg, int task), void *arg) {
+	struct taskPool pool;
+	struct poolWorker *workers;
+	struct taskCost *order;
+	pthread_t *threads;
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	int i;
+
+	pool.nworkers = ncpu < 1 ? 1 : ncpu < ntasks ? (int)ncpu : ntasks;
+	pool.run = run;
+	pool.arg = arg;
+	if(ntasks == 0)
+		return;
+
+	order = (struct taskCost *)malloc(sizeof(struct taskCost) * ntasks);
+	for(i = 0; i < ntasks; i++) {
+		order[i].cost = work[i];
+		order[i].task = i;
+	}
+	qsort(order, ntasks, sizeof(struct taskCost), taskCostCompare);
+
+	pool.deques = (struct taskDeque *)malloc(sizeof(struct taskDeque) * pool.nworkers);
+	for(i = 0; i < pool.nworkers; i++) {
+		pthread_mutex_init(&pool.deques[i].lock, NULL);
+		pool.deques[i].task = (int *)malloc(sizeof(int) * (ntasks / pool.nworkers + 1));
+		pool.deques[i].head = pool.deques[i].tail = 0;
+	}
+	for(i = 0; i < ntasks; i++) {
+		struct taskDeque *d = &pool.deques[i % pool.nworkers];
+		d->task[d->tail++] = order[i].task;
+	}
+
+	workers = (struct poolWorker *)malloc(sizeof(struct poolWorker) * pool.nworkers);
+	threads = (pthread_t *)malloc(sizeof(pthread_t) * pool.nworkers);
+	for(i = 0; i < pool.nworkers; i++) {
+		workers[i].pool = &pool;
+		workers[i].id = i;
+		if(pthread_create(&threads[i], NULL, poolWorkerMain, &workers[i]) != 0) {
+			printf("pthread_create failed\n"); exit(1);
+		}
+	}
+	for(i = 0; i < pool.nworkers; i++)
+		pthread_join(threads[i], NULL);
+
+	for(i = 0; i < pool.nworkers; i++) {
+		pthread_mutex_destroy(&pool.deques[i].lock);
+		free(pool.deques[i].task);
+	}
+	free(pool.deques);
+	free(threads);
+	free(workers);
+	free(order);
+}
+
+// local replacement 실행 상태. task k는 (시뮬레이션 k / numProcess, 프로세스 k % numProcess)
+struct localRun {
+	struct procEntry *procTable;
+	const char *types, *policies;	// 시뮬레이션별 page table 종류와 replacement policy
+	int preferBinary;
+	int *quota;					// 프로세스별 frame 수
+	uint64_t *footprint;		// 프로세스별 distinct page 수 ('w')
+	struct procEntry *results;	// task별 결과 통계
+	uint64_t *tableBytes;		// task별 tableArena 크기
+};
+
+// trace를 한 번 읽는 비용의 추정치 (bytes)
+static uint64_t traceWork(struct traceFile *trace) {
+	struct stat st;
+
+	if(trace->format == TRACE_BINARY)
+		return trace->mapSize;
+	return fstat(trace->fd, &st) == 0 ? (uint64_t)st.st_size : 0;
+}
+
+// task마다 trace를 따로 열어야 읽는 위치가 섞이지 않는다
+static void localOpenTrace(struct localRun *run, int i, struct traceFile *trace) {
+	if(openTrace(trace, run->procTable[i].traceName, run->preferBinary) != 0) {
+		printf("cannot open %s\n", run->procTable[i].traceName); exit(1);
+	}
+}
+
+static void footprintTask(void *arg, int i) {
+	struct localRun *run = (struct localRun *)arg;
+	struct traceFile trace;
+	struct pageMap seen;
+	uint64_t addr;
+	char rw;
+
+	localOpenTrace(run, i, &trace);
+	pageMapInit(&seen, 1024);
+	while(readTrace(&trace, &addr, &rw) != EOF)	// 시뮬레이션들은 모두 32bit이거나 모두 '4'
+		pageMapPut(&seen, simPage(run->types[0], addr), 0, NULL);
+	run->footprint[i] = seen.count;
+	pageMapFree(&seen);
+	closeTrace(&trace);
+}
+
+static void localSimTask(void *arg, int k) {
+	struct localRun *run = (struct localRun *)arg;
+	int i = k % numProcess, n = k / numProcess;
+	struct traceFile trace;
+	struct vmSim sim;
+	uint64_t addr;
+	char rw;
+
+	localOpenTrace(run, i, &trace);
+	initVMSim(&sim, run->types[n], run->policies[n], &run->procTable[i], 1, run->quota[i]);
+	while(readTrace(&trace, &addr, &rw) != EOF)
+		vmSimAccess(&sim, 0, addr, rw);
+	run->results[k] = sim.procTable[0];
+	run->tableBytes[k] = sim.tableArena.bytes;
+	freeVMSim(&sim);
+	closeTrace(&trace);
+}
+
+// 프로세스별 frame quota. 합이 nFrame을 넘지 않게 나눈다. 실패하면 -1
+int localQuota(struct localRun *run) {
+	uint64_t total = 0, *work;
+	int i, left = nFrame;
+
+	if(localConf.alloc == 'u') {
+		if(localConf.nquota != numProcess) {
+			printf("-l gives %d frame quotas for %d processes\n", localConf.nquota, numProcess); return -1;
+		}
+		for(i = 0; i < numProcess; i++) {
+			run->quota[i] = localConf.quota[i];
+			left -= run->quota[i];
+		}
+		if(left < 0) {
+			printf("frame quotas need %d more frames than the %d physical frames\n", -left, nFrame); return -1;
+		}
+		return 0;
+	}
+	if(nFrame < numProcess) {
+		printf("%d frames cannot be shared by %d processes\n", nFrame, numProcess); return -1;
+	}
+
+	if(localConf.alloc == 'e') {
+		for(i = 0; i < numProcess; i++)
+			run->quota[i] = nFrame / numProcess + (i < nFrame % numProcess);
+		return 0;
+	}
+
+	// footprint 비례. 모든 프로세스가 최소 1 frame을 가지고, 나머지는 footprint에 비례해서 (내림) 나눈 뒤
+	// 남은 frame을 앞 프로세스부터 하나씩 준다
+	work = (uint64_t *)malloc(sizeof(uint64_t) * numProcess);
+	for(i = 0; i < numProcess; i++)
+		work[i] = traceWork(&run->procTable[i].trace);
+	runTaskPool(numProcess, work, footprintTask, run);
+	free(work);
+	for(i = 0; i < numProcess; i++)
+		total += run->footprint[i];
+	left = nFrame - numProcess;
+	for(i = 0; i < numProcess; i++) {
+		run->quota[i] = 1 + (total ? (int)((double)(nFrame - numProcess) * run->footprint[i] / total) : 0);
+		left -= run->quota[i] - 1;
+	}
+	for(i = 0; left > 0; i = (i + 1) % numProcess, left--)
+		run->quota[i]++;
+	return 0;
+}
+
+// local replacement. 시뮬레이션마다 프로세스별 instance를 만들어 thread pool에서 동시에 돌리고,
+// 시뮬레이션 순서대로 프로세스별 결과와 전체 합계를 출력한다
+int runLocalVMSims(const char *types, const char *policies, int nsims, struct procEntry *procTable, int preferBinary) {
+	struct localRun run;
+	uint64_t *work;
+	double totalIoTime;
+	long long totalFault, totalHit, totalDirty, totalTraces;
+	uint64_t tableBytes;
+	int ntasks = nsims * numProcess;
+	int i, n, k;
+
+	run.procTable = procTable;
+	run.types = types;
+	run.policies = policies;
+	run.preferBinary = preferBinary;
+	run.quota = (int *)malloc(sizeof(int) * numProcess);
+	run.footprint = (uint64_t *)calloc(numProcess, sizeof(uint64_t));
+	run.results = (struct procEntry *)malloc(sizeof(struct procEntry) * ntasks);
+	run.tableBytes = (uint64_t *)malloc(sizeof(uint64_t) * ntasks);
+	if(localQuota(&run) != 0) {
+		free(run.quota); free(run.footprint); free(run.results); free(run.tableBytes);
+		return -1;
+	}
+
+	work = (uint64_t *)malloc(sizeof(uint64_t) * ntasks);
+	for(k = 0; k < ntasks; k++)
+		work[k] = traceWork(&procTable[k % numProcess].trace);
+	runTaskPool(ntasks, work, localSimTask, &run);
+	free(work);
+
+	for(n = 0; n < nsims; n++) {
+		const char *name = findPolicy(policies[n])->name;
+		printf("=============================================================\n");
+		if(types[n] == '0')
+			printf("The One-Level Page Table with %s Local Replacement Memory Simulation Starts .....\n", name);
+		else if(types[n] == '4')
+			printf("The %d-Level Page Table with %s Local Replacement Memory Simulation Starts .....\n", radixConf.levels, name);
+		else
+			printf("The %s Page Table with %s Local Replacement Memory Simulation Starts .....\n",
+					types[n] == '1' ? "Two-Level" : "Inverted", name);
+		printf("=============================================================\n");
+
+		totalIoTime = 0;
+		totalFault = totalHit = totalDirty = totalTraces = 0;
+		tableBytes = 0;
+		for(i = 0; i < numProcess; i++) {
+			struct procEntry *proc = &run.results[n * numProcess + i];
+			totalIoTime += reportProc(proc, i, types[n]);
+			if(localConf.alloc == 'w')
+				printf("Proc %d Frame quota %d (%llu distinct pages)\n", i, run.quota[i], (unsigned long long)run.footprint[i]);
+			else
+				printf("Proc %d Frame quota %d\n", i, run.quota[i]);
+			totalFault += proc->numPageFault;
+			totalHit += proc->numPageHit;
+			totalDirty += proc->numDirtyEviction;
+			totalTraces += proc->ntraces;
+			tableBytes += run.tableBytes[n * numProcess + i];
+		}
+		printf("Total Num of Page Faults %lld Page Hit %lld\n", totalFault, totalHit);
+		printf("Total Num of Dirty Evictions %lld Simulated I/O time %.3f ms Effective memory access time %.1f ns\n",
+				totalDirty, totalIoTime / 1e6, totalTraces ? cost.memAccess + totalIoTime / totalTraces : 0.0);
+		if(types[n] == '4')
+			printf("Radix page table %d-bit virtual address, %llu bytes of tables\n", radixConf.vaBits, (unsigned long long)tableBytes);
+	}
+
+	free(run.quota);
+	free(run.footprint);
+	free(run.results);
+	free(run.tableBytes);
+	return 0;
+}
+
+// Mattson stack distance. LRU는 stack algorithm이므로 access마다 LRU stack에서의 위치(distance)를 구하면
+// frame 개수 F인 LRU에서 그 access는 distance <= F일 때만 hit이다. 한 번의 pass로 모든 F의 fault 수를 구한다
+#define MRC_MAXBITS (VIRTUALADDRBITS - pageSizeBits)	// frame 개수 2^0 ~ 2^20까지 (4K page)
+#define MRC_EMPTY UINT64_MAX		// 빈 hash slot
+#define MRC_DEAD UINT32_MAX			// 마지막 access가 아닌 시간
+
+struct stackDist {
+	uint64_t *keys;				// (pid, VPN) open addressing hash
+	uint32_t *times;			// key가 마지막으로 access된 시간
+	uint32_t hashSize, nkeys;
+	uint32_t *tree;				// Fenwick tree. 시간 t가 어떤 key의 마지막 access이면 1
+	uint32_t *timeSlot;			// 시간 t에 access된 key의 hash slot (없으면 MRC_DEAD)
+	uint32_t cap, now;			// tree 크기, 다음 access의 시간 (1부터)
+};
+
+static void sdAlloc(struct stackDist *sd, uint32_t hashSize, uint32_t cap) {
+	uint32_t i;
+	sd->hashSize = hashSize;
+	sd->keys = (uint64_t *)malloc(sizeof(uint64_t) * hashSize);
+	sd->times = (uint32_t *)malloc(sizeof(uint32_t) * hashSize);
+	for(i = 0; i < hashSize; i++)
+		sd->keys[i] = MRC_EMPTY;
+	sd->cap = cap;
+	sd->tree = (uint32_t *)calloc(cap + 1, sizeof(uint32_t));
+	sd->timeSlot = (uint32_t *)malloc(sizeof(uint32_t) * (cap + 1));
+	for(i = 0; i <= cap; i++)
+		sd->timeSlot[i] = MRC_DEAD;
+}
+
+void sdInit(struct stackDist *sd) {
+	sdAlloc(sd, 1 << 16, 1 << 16);
+	sd->nkeys = 0;
+	sd->now = 1;
+}
+
+void sdFree(struct stackDist *sd) {
+	free(sd->keys);
+	free(sd->times);
+	free(sd->tree);
+	free(sd->timeSlot);
+}
+
+static inline void sdTreeAdd(struct stackDist *sd, uint32_t t, int delta) {
+	for(; t <= sd->cap; t += t & -t)
+		sd->tree[t] += delta;
+}
+
+static inline uint32_t sdTreeSum(struct stackDist *sd, uint32_t t) {	// [1, t]의 합
+	uint32_t sum = 0;
+	for(; t > 0; t -= t & -t)
+		sum += sd->tree[t];
+	return sum;
+}
+
+// hash가 반 이상 차면 두 배로 늘린다
+static void sdGrowHash(struct stackDist *sd) {
+	uint64_t *oldKeys = sd->keys;
+	uint32_t *oldTimes = sd->times;
+	uint32_t oldSize = sd->hashSize, i, slot;
+
+	sd->hashSize = oldSize * 2;
+	sd->keys = (uint64_t *)malloc(sizeof(uint64_t) * sd->hashSize);
+	sd->times = (uint32_t *)malloc(sizeof(uint32_t) * sd->hashSize);
+	for(i = 0; i < sd->hashSize; i++)
+		sd->keys[i] = MRC_EMPTY;
+	for(i = 0; i < oldSize; i++) {
+		if(oldKeys[i] == MRC_EMPTY)
+			continue;
+		slot = mix64(oldKeys[i]) & (sd->hashSize - 1);
+		while(sd->keys[slot] != MRC_EMPTY)
+			slot = (slot + 1) & (sd->hashSize - 1);
+		sd->keys[slot] = oldKeys[i];
+		sd->times[slot] = oldTimes[i];
+		sd->timeSlot[oldTimes[i]] = slot;
+	}
+	free(oldKeys);
+	free(oldTimes);
+}
+
+// 시간이 tree 끝에 닿으면 살아있는 시간들만 1..nkeys로 다시 번호를 매긴다. tree는 distinct page 수에 비례
+static void sdCompact(struct stackDist *sd) {
+	uint32_t t, newt = 0, cap, i, lowbit;
+
+	for(t = 1; t < sd->now; t++)
+		if(sd->timeSlot[t] != MRC_DEAD) {
+			newt++;
+			sd->timeSlot[newt] = sd->timeSlot[t];
+			sd->times[sd->timeSlot[newt]] = newt;
+		}
+
+	cap = sd->cap;
+	if(sd->nkeys * 2 > cap) {
+		while(sd->nkeys * 2 > cap)
+			cap *= 2;
+		sd->tree = (uint32_t *)realloc(sd->tree, sizeof(uint32_t) * (cap + 1));
+		sd->timeSlot = (uint32_t *)realloc(sd->timeSlot, sizeof(uint32_t) * (cap + 1));
+		sd->cap = cap;
+	}
+	for(t = newt + 1; t <= cap; t++)
+		sd->timeSlot[t] = MRC_DEAD;
+	// [1, nkeys]가 모두 1인 Fenwick tree
+	for(i = 1; i <= cap; i++) {
+		lowbit = i & -i;
+		sd->tree[i] = (i - lowbit >= sd->nkeys) ? 0 : ((i < sd->nkeys ? i : sd->nkeys) - (i - lowbit));
+	}
+	sd->now = newt + 1;
+}
+
+// key를 access하고 stack distance를 돌려준다. 처음 보는 key이면 0 (cold miss)
+uint32_t sdAccess(struct stackDist *sd, uint64_t key) {
+	uint32_t slot, dist;
+
+	if(sd->now > sd->cap)
+		sdCompact(sd);
+
+	slot = mix64(key) & (sd->hashSize - 1);
+	while(sd->keys[slot] != MRC_EMPTY && sd->keys[slot] != key)
+		slot = (slot + 1) & (sd->hashSize - 1);
+
+	if(sd->keys[slot] == key) {
+		// 마지막 access 이후(포함) 살아있는 시간의 개수 = 그 사이에 access된 distinct key 수
+		dist = sd->nkeys - sdTreeSum(sd, sd->times[slot] - 1);
+		sdTreeAdd(sd, sd->times[slot], -1);
+		sd->timeSlot[sd->times[slot]] = MRC_DEAD;
+	}
+	else {
+		dist = 0;
+		sd->keys[slot] = key;
+		sd->nkeys++;
+	}
+	sd->times[slot] = sd->now;
+	sd->timeSlot[sd->now] = slot;
+	sdTreeAdd(sd, sd->now, 1);
+	sd->now++;
+
+	if(sd->nkeys * 2 > sd->hashSize)
+		sdGrowHash(sd);
+	return dist;
+}
+
+// distance d인 access는 frame 2^k개에서 k < bucket(d)일 때 fault. bucket(d) = ceil(log2(d))
+static inline int mrcBucket(uint32_t dist) {
+	return dist <= 1 ? 0 : 32 - __builtin_clz(dist - 1);
+}
+
+// 모든 physical memory 크기(frame 2^0 ~ 2^MRC_MAXBITS)에 대한 global LRU page fault 수를 한 번에 구한다.
+// validate이면 각 크기마다 one-level LRU 시뮬레이션을 돌려서 결과가 같은지 확인한다
+int missRatioCurve(struct procEntry *procTable, int validate) {
+	struct stackDist sd;
+	struct scheduler sched;
+	uint64_t (*hist)[33];		// 프로세스별 bucket(distance) histogram. [32]는 cold miss
+	uint64_t *ntraces;
+	uint64_t faults, total, procFaults;
+	uint64_t addr;
+	char rw;
+	int i, k, b, ret = 0;
+
+	hist = calloc(numProcess, sizeof(*hist));
+	ntraces = (uint64_t *)calloc(numProcess, sizeof(uint64_t));
+
+	sdInit(&sd);
+	initScheduler(&sched, procTable);
+	while(readSchedule(&sched, &i, &addr, &rw) != EOF) {
+		uint32_t dist = sdAccess(&sd, pageKey(i, addr >> pageSizeBits));
+		hist[i][dist == 0 ? 32 : mrcBucket(dist)]++;
+		ntraces[i]++;
+	}
+	freeScheduler(&sched);
+	for(i = 0; i < numProcess; i++)
+		rewindTrace(&procTable[i].trace);
+
+	printf("=============================================================\n");
+	printf("The LRU Miss Ratio Curve (Mattson Stack Distance) Starts .....\n");
+	printf("=============================================================\n");
+	total = 0;
+	for(i = 0; i < numProcess; i++) {
+		printf("Proc %d %s Num of traces %llu\n", i, procTable[i].traceName, (unsigned long long)ntraces[i]);
+		total += ntraces[i];
+	}
+	printf("Num of distinct pages %u\n", sd.nkeys);
+	printf("%10s %8s %12s %10s", "Frames", "MemBits", "PageFaults", "MissRatio");
+	for(i = 0; i < numProcess; i++) {
+		char label[32];
+		snprintf(label, sizeof(label), "Proc%d", i);
+		printf(" %14s", label);
+	}
+	printf("\n");
+
+	for(k = 0; k <= MRC_MAXBITS; k++) {
+		faults = 0;
+		for(i = 0; i < numProcess; i++)
+			for(b = k + 1; b <= 32; b++)
+				faults += hist[i][b];
+		printf("%10lu %8d %12llu %10.6f", 1UL << k, k + pageSizeBits, (unsigned long long)faults, total ? (double)faults / total : 0.0);
+		for(i = 0; i < numProcess; i++) {
+			procFaults = 0;
+			for(b = k + 1; b <= 32; b++)
+				procFaults += hist[i][b];
+			printf(" %14llu", (unsigned long long)procFaults);
+		}
+		printf("\n");
+	}
+
+	if(validate) {
+		struct vmSim sim;
+		printf("=============================================================\n");
+		printf("Validating against the One-Level Page Table with LRU .....\n");
+		printf("=============================================================\n");
+		for(k = 0; k <= MRC_MAXBITS; k++) {
+			int match = 1;
+			initVMSim(&sim, '0', 'L', procTable, numProcess, 1 << k);
+			initScheduler(&sched, procTable);
+			while(readSchedule(&sched, &i, &addr, &rw) != EOF)
+				vmSimAccess(&sim, i, addr, rw);
+			freeScheduler(&sched);
+			for(i = 0; i < numProcess; i++) {
+				procFaults = 0;
+				for(b = k + 1; b <= 32; b++)
+					procFaults += hist[i][b];
+				if((uint64_t)sim.procTable[i].numPageFault != procFaults)
+					match = 0;
+				rewindTrace(&procTable[i].trace);
+			}
+			printf("Frames %lu %s\n", 1UL << k, match ? "matches oneLevelVMSim LRU" : "MISMATCH with oneLevelVMSim LRU");
+			if(!match)
+				ret = -1;
+			freeVMSim(&sim);
+		}
+	}
+
+	sdFree(&sd);
+	free(hist);
+	free(ntraces);
+	return ret;
+}
+
+// page table 구성별 메모리 사용량
+struct footprintRow {
+	char config[32];
+	int firstLevelBits;			// two-level이 아니면 0
+	uint64_t num2ndLevelPageTable;
+	uint64_t firstLevelBytes;
+	uint64_t secondLevelBytes;
+	uint64_t totalBytes;
+};
+
+static int footprintCompare(const void *a, const void *b) {
+	const struct footprintRow *x = (const struct footprintRow *)a, *y = (const struct footprintRow *)b;
+	if(x->totalBytes != y->totalBytes)
+		return x->totalBytes < y->totalBytes ? -1 : 1;
+	return x->firstLevelBits - y->firstLevelBits;
+}
+
+// trace를 한 번 읽고 모든 firstLevelBits(1..19)에 대해 two-level page table이 만드는 2nd level table 수와
+// 메모리를 구한다. 2nd level table은 한 번 만들어지면 해제되지 않으므로 프로세스가 건드린 VPN의 상위 firstLevelBits bit
+// 종류 수와 같다. one-level과 inverted page table의 메모리도 같이 출력하고, 전부 메모리 순으로 정렬한다
+void pageTableFootprint(struct procEntry *procTable, int nFrame) {
+	const int vpnBits = VIRTUALADDRBITS - pageSizeBits;
+	struct footprintRow rows[VIRTUALADDRBITS - PAGESIZEBITS + 1];	// 배열 크기는 가장 작은 page 기준
+	unsigned char **used;		// 프로세스별로 access된 VPN (prefix) 표시
+	uint64_t tables[VIRTUALADDRBITS - PAGESIZEBITS] = {0};	// firstLevelBits별 2nd level table 수 (전체 프로세스)
+	uint64_t distinctPages = 0, ntraces = 0, residentEntries;
+	uint64_t addr;
+	char rw;
+	int i, f, nrows = 0;
+	uint32_t j;
+
+	used = (unsigned char **)malloc(sizeof(unsigned char *) * numProcess);
+	for(i = 0; i < numProcess; i++)
+		used[i] = (unsigned char *)calloc(PAGETABLESIZE, 1);
+
+	// 프로세스별로 독립적이므로 round-robin할 필요 없이 trace를 하나씩 읽는다
+	for(i = 0; i < numProcess; i++) {
+		while(readTrace(&procTable[i].trace, &addr, &rw) != EOF) {
+			used[i][(uint32_t)addr >> pageSizeBits] = 1;	// 32bit page table 분석
+			ntraces++;
+		}
+		rewindTrace(&procTable[i].trace);
+
+		for(j = 0; j < PAGETABLESIZE; j++)
+			distinctPages += used[i][j];
+		// 상위 bit가 같은 두 칸을 합쳐가며 firstLevelBits = 19, 18, ..., 1일 때의 prefix 종류를 센다.
+		// tables[0]은 page를 하나라도 건드린 프로세스 수
+		for(f = vpnBits - 1; f >= 0; f--)
+			for(j = 0; j < (1u << f); j++) {
+				used[i][j] = used[i][2 * j] | used[i][2 * j + 1];
+				tables[f] += used[i][j];
+			}
+		free(used[i]);
+	}
+	free(used);
+
+	for(f = 1; f < vpnBits; f++) {
+		snprintf(rows[nrows].config, sizeof(rows[nrows].config), "Two-Level");
+		rows[nrows].firstLevelBits = f;
+		rows[nrows].num2ndLevelPageTable = tables[f];
+		rows[nrows].firstLevelBytes = (uint64_t)numProcess * (1ULL << f) * sizeof(struct pageTableEntry);
+		rows[nrows].secondLevelBytes = tables[f] * (1ULL << (vpnBits - f)) * sizeof(struct pageTableEntry2);
+		rows[nrows].totalBytes = rows[nrows].firstLevelBytes + rows[nrows].secondLevelBytes;
+		nrows++;
+	}
+
+	// one-level은 chunk directory와, 건드린 VPN의 상위 (vpnBits - PTECHUNKBITS) bit 종류 수만큼의 PTE chunk
+	snprintf(rows[nrows].config, sizeof(rows[nrows].config), "One-Level");
+	rows[nrows].firstLevelBits = 0;
+	rows[nrows].num2ndLevelPageTable = 0;
+	rows[nrows].firstLevelBytes = (uint64_t)numProcess * PTEDIRSIZE * sizeof(pte_t *);
+	rows[nrows].secondLevelBytes = tables[vpnBits > PTECHUNKBITS ? vpnBits - PTECHUNKBITS : 0] * PTECHUNKSIZE * sizeof(pte_t);
+	rows[nrows].totalBytes = rows[nrows].firstLevelBytes + rows[nrows].secondLevelBytes;
+	nrows++;
+
+	// inverted는 frame 수만큼의 hash head와, 최대 frame 수만큼 매핑된 page의 entry
+	residentEntries = distinctPages < (uint64_t)nFrame ? distinctPages : (uint64_t)nFrame;
+	snprintf(rows[nrows].config, sizeof(rows[nrows].config), "Inverted");
+	rows[nrows].firstLevelBits = 0;
+	rows[nrows].num2ndLevelPageTable = 0;
+	rows[nrows].firstLevelBytes = (uint64_t)nFrame * sizeof(struct invertedPageTableEntry);
+	rows[nrows].secondLevelBytes = residentEntries * sizeof(struct invertedPageTableEntry);
+	rows[nrows].totalBytes = rows[nrows].firstLevelBytes + rows[nrows].secondLevelBytes;
+	nrows++;
+
+	qsort(rows, nrows, sizeof(struct footprintRow), footprintCompare);
+
+	printf("=============================================================\n");
+	printf("The Page Table Footprint Analysis Starts .....\n");
+	printf("=============================================================\n");
+	printf("Num of traces %llu Num of distinct pages %llu Num of Frames %d\n",
+			(unsigned long long)ntraces, (unsigned long long)distinctPages, nFrame);
+	printf("%-10s %14s %14s %16s %16s %16s\n", "Config", "firstLevelBits", "2ndLevelTables", "1stLevelBytes", "2ndLevelBytes", "TotalBytes");
+	for(i = 0; i < nrows; i++) {
+		if(rows[i].firstLevelBits)
+			printf("%-10s %14d %14llu", rows[i].config, rows[i].firstLevelBits, (unsigned long long)rows[i].num2ndLevelPageTable);
+		else
+			printf("%-10s %14s %14s", rows[i].config, "-", "-");
+		printf(" %16llu %16llu %16llu\n", (unsigned long long)rows[i].firstLevelBytes,
+				(unsigned long long)rows[i].secondLevelBytes, (unsigned long long)rows[i].totalBytes);
+	}
+}
+
+// SHARDS 식 sampling의 page hash. 다른 hash들(pageMap, inverted table의 mix64)과 겹치지 않게 key를 섞어서 쓴다.
+// sample에 들어온 page들이 한 bucket으로 몰리지 않도록 하기 위함
+static inline uint64_t sampleHash(int pid, uint64_t vpn) {
+	return mix64(pageKey(pid, vpn) + 0x9e3779b97f4a7c15ULL);
+}
+
+#define SAMPLE_BUCKETS 32		// 오차 추정에 쓰는 page 그룹 수 (hash의 하위 bit)
+
+static int hashCompare(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+// 고정 크기 sample의 threshold. trace들을 한 번 읽으며 threshold 이하인 서로 다른 page의 hash 중 가장 작은 smax개를 남긴다.
+// 후보가 2 * smax개 쌓이면 정렬해서 중복을 지우고 작은 smax개만 남기므로 메모리는 smax에 비례한다.
+// page는 type의 시뮬레이터가 보는 simPage()로 센다.
+// page가 smax개 이하이면 threshold를 그대로 돌려준다. *npages에 sample에 남은 page 수를 돌려준다
+uint64_t sampleThresholdFixed(struct procEntry *procTable, char type, uint64_t threshold, uint64_t smax, uint64_t *npages) {
+	uint64_t *cand, n = 0, k, m, h, initial = threshold;
+	uint64_t addr;
+	char rw;
+	int i;
+
+	cand = (uint64_t *)malloc(sizeof(uint64_t) * 2 * smax);
+	for(i = 0; i < numProcess; i++) {
+		while(readTrace(&procTable[i].trace, &addr, &rw) != EOF) {
+			h = sampleHash(i, simPage(type, addr));
+			if(h > threshold)
+				continue;
+			cand[n++] = h;
+			if(n < 2 * smax)
+				continue;
+			qsort(cand, n, sizeof(uint64_t), hashCompare);
+			for(k = m = 0; k < n && m < smax; k++)
+				if(m == 0 || cand[k] != cand[m - 1])
+					cand[m++] = cand[k];
+			n = m;
+			if(n == smax)
+				threshold = cand[n - 1];
+		}
+		rewindTrace(&procTable[i].trace);
+	}
+	qsort(cand, n, sizeof(uint64_t), hashCompare);
+	for(k = m = 0; k < n && m < smax; k++)
+		if(m == 0 || cand[k] != cand[m - 1])
+			cand[m++] = cand[k];
+	while(k < n && m > 0 && cand[k] == cand[m - 1])	// 남은 후보 중 다른 page가 있으면 smax개를 넘는다
+		k++;
+	if(m == smax && (threshold != initial || k < n))
+		threshold = cand[m - 1];
+	*npages = m;
+	free(cand);
+	return threshold;
+}
+
+// sampling한 시뮬레이션. scheduler의 access 중 sampleHash(pid, simPage) <= threshold인 것만 sims에 넣는다.
+// sims는 frame 수를 rate만큼 줄여서 만들어 둔다. 프로세스별 fault ratio는 sample 안에서 구해서 (SHARDS의 조정)
+// 실제 access 수에 곱하고, 오차는 page를 hash로 SAMPLE_BUCKETS개 그룹으로 나눠 ratio 추정량의 분산으로 구한다.
+// validate이면 같은 구성을 frame 전체로 정확히 시뮬레이션해서 비교한다
+int runSampledVMSims(struct vmSim *sims, int nsims, struct procEntry *procTable, uint64_t threshold, int validate) {
+	struct scheduler sched;
+	uint64_t addrs[SCHED_BATCH], h, (*bucketRef)[SAMPLE_BUCKETS], (*bucketFault)[SAMPLE_BUCKETS];
+	char rws[SCHED_BATCH];
+	unsigned char bucket[SCHED_BATCH];
+	uint64_t *total, *sampled, totalAll = 0, sampledAll = 0;
+	double rate = threshold == UINT64_MAX ? 1.0 : ldexp((double)threshold, -64);
+	double ratio, var, bound, exactRatio;
+	long long faults, exactFaults;
+	int i, j, n, m, s, b, ret = 0;
+
+	total = (uint64_t *)calloc(numProcess, sizeof(uint64_t));
+	sampled = (uint64_t *)calloc(numProcess, sizeof(uint64_t));
+	bucketRef = calloc(nsims, sizeof(*bucketRef));
+	bucketFault = calloc(nsims, sizeof(*bucketFault));
+
+	initScheduler(&sched, procTable);
+	while((n = readScheduleBatch(&sched, &i, addrs, rws, SCHED_BATCH)) > 0) {
+		total[i] += n;
+		for(j = m = 0; j < n; j++) {	// sample에 들어온 access만 앞으로 모은다
+			h = sampleHash(i, simPage(sims[0].type, addrs[j]));
+			if(h > threshold)
+				continue;
+			addrs[m] = addrs[j];
+			rws[m] = rws[j];
+			bucket[m++] = h % SAMPLE_BUCKETS;
+		}
+		sampled[i] += m;
+		for(s = 0; s < nsims; s++)
+			for(j = 0; j < m; j++) {
+				faults = sims[s].procTable[i].numPageFault;
+				vmSimAccess(&sims[s], i, addrs[j], rws[j]);
+				bucketRef[s][bucket[j]]++;
+				bucketFault[s][bucket[j]] += sims[s].procTable[i].numPageFault - faults;
+			}
+	}
+	freeScheduler(&sched);
+	for(i = 0; i < numProcess; i++) {
+		rewindTrace(&procTable[i].trace);
+		totalAll += total[i];
+		sampledAll += sampled[i];
+	}
+
+	for(s = 0; s < nsims; s++) {
+		struct procEntry *proc = sims[s].procTable;
+		printf("=============================================================\n");
+		printf("%s\n", vmSimTitle(&sims[s]));
+		printf("=============================================================\n");
+		printf("Sampling rate %.6f, %d of %d frames, %llu of %llu accesses sampled (%.6f)\n", rate, sims[s].nFrame, nFrame,
+				(unsigned long long)sampledAll, (unsigned long long)totalAll, totalAll ? (double)sampledAll / totalAll : 0.0);
+		faults = 0;
+		for(i = 0; i < numProcess; i++) {
+			ratio = sampled[i] ? (double)proc[i].numPageFault / sampled[i] : 0.0;
+			printf("**** %s *****\n", proc[i].traceName);
+			printf("Proc %d Num of traces %llu (%llu sampled)\n", i, (unsigned long long)total[i], (unsigned long long)sampled[i]);
+			printf("Proc %d Estimated Num of Page Faults %.0f (%lld sampled)\n", i, ratio * total[i], proc[i].numPageFault);
+			printf("Proc %d Estimated Num of Page Hit %.0f (%lld sampled)\n", i, (1.0 - ratio) * total[i], proc[i].numPageHit);
+			printf("Proc %d Estimated fault ratio %.6f\n", i, ratio);
+			faults += proc[i].numPageFault;
+		}
+
+		// 그룹 b의 access 수 N_b, fault 수 F_b로 Var(F/N) ~= B/(B-1) * sum (F_b - ratio * N_b)^2 / N^2
+		ratio = sampledAll ? (double)faults / sampledAll : 0.0;
+		var = 0;
+		for(b = 0; b < SAMPLE_BUCKETS; b++)
+			var += ((double)bucketFault[s][b] - ratio * bucketRef[s][b]) * ((double)bucketFault[s][b] - ratio * bucketRef[s][b]);
+		var = sampledAll ? var * SAMPLE_BUCKETS / (SAMPLE_BUCKETS - 1) / ((double)sampledAll * sampledAll) : 0.0;
+		bound = 1.96 * sqrt(var);
+		printf("Estimated total fault ratio %.6f +- %.6f (95%%), page faults %.0f +- %.0f\n", ratio, bound,
+				ratio * totalAll, bound * totalAll);
+
+		if(validate) {
+			struct vmSim exact;
+			initVMSim(&exact, sims[s].type, sims[s].policy->code, procTable, numProcess, nFrame);
+			initScheduler(&sched, procTable);
+			while((n = readScheduleBatch(&sched, &i, addrs, rws, SCHED_BATCH)) > 0)
+				for(j = 0; j < n; j++)
+					vmSimAccess(&exact, i, addrs[j], rws[j]);
+			freeScheduler(&sched);
+			exactFaults = 0;
+			for(i = 0; i < numProcess; i++) {
+				rewindTrace(&procTable[i].trace);
+				printf("Proc %d Exact Num of Page Faults %lld (estimate off by %+.2f%%)\n", i, exact.procTable[i].numPageFault,
+						exact.procTable[i].numPageFault ? 100.0 * ((sampled[i] ? (double)proc[i].numPageFault / sampled[i] : 0.0)
+						* total[i] - exact.procTable[i].numPageFault) / exact.procTable[i].numPageFault : 0.0);
+				exactFaults += exact.procTable[i].numPageFault;
+			}
+			exactRatio = totalAll ? (double)exactFaults / totalAll : 0.0;
+			printf("Exact total fault ratio %.6f, estimate error %.6f, %s\n", exactRatio, ratio - exactRatio,
+					fabs(ratio - exactRatio) <= bound ? "within the 95% bound" : "OUTSIDE the 95% bound");
+			if(fabs(ratio - exactRatio) > bound)
+				ret = -1;
+			freeVMSim(&exact);
+		}
+	}
+
+	free(total);
+	free(sampled);
+	free(bucketRef);
+	free(bucketFault);
+	return ret;
+}
+
+double nowSec(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+struct decodeRun {
+	struct traceFile *trace;
+	uint64_t *hash;				// block별 (addr, rw, timestamp) hash
+	int failed;
+};
+
+static inline uint64_t recordHash(uint64_t h, uint64_t addr, char rw, uint64_t time) {
+	return (((h ^ addr) * 0x100000001b3ULL ^ (unsigned char)rw) * 0x100000001b3ULL ^ time) * 0x100000001b3ULL;
+}
+
+// block 하나를 자기 버퍼로 decode한다. block끼리 delta 기준이 따로라서 순서와 상관없이 돌릴 수 있다
+void decodeBlockTask(void *arg, int task) {
+	struct decodeRun *run = (struct decodeRun *)arg;
+	struct ctrace *ct = run->trace->ct;
+	const struct ctraceBlock *blk = &ct->index[task];
+	unsigned char *stored = (unsigned char *)malloc(blk->storedSize + 1), *raw = (unsigned char *)malloc(blk->rawSize + 1);
+	uint64_t *addrs = (uint64_t *)malloc(sizeof(uint64_t) * (blk->nrecords + 1));
+	uint64_t *times = (uint64_t *)malloc(sizeof(uint64_t) * (blk->nrecords + 1));
+	char *rws = (char *)malloc(blk->nrecords + 1);
+	uint64_t h = 0;
+	int k, n;
+
+	if((n = decodeCtraceBlock(run->trace->fd, ct->header.flags, blk, stored, raw, addrs, rws, times)) < 0)
+		run->failed = 1;
+	for(k = 0; k < n; k++)
+		h = recordHash(h, addrs[k], rws[k], times[k]);
+	run->hash[task] = h;
+	free(stored);
+	free(raw);
+	free(addrs);
+	free(times);
+	free(rws);
+}
+
+// 압축 trace decoding 속도 측정. readTrace로 처음부터 차례로 읽는 것과 block들을 thread pool에서 따로 decode하는 것을 비교한다
+int decodeThroughput(const char *name) {
+	struct traceFile trace;
+	struct decodeRun run;
+	struct ctrace *ct;
+	uint64_t *hash, *work, addr, n = 0, b, h = 0;
+	char rw;
+	double start, tSeq, tPar;
+	int ret = 0;
+
+	if(openTrace(&trace, name, 0) != 0 || trace.format != TRACE_COMPRESSED) {
+		printf("%s is not a readable compressed trace\n", name);
+		return -1;
+	}
+	ct = trace.ct;
+	hash = (uint64_t *)calloc(ct->header.nblocks + 1, sizeof(uint64_t));
+	work = (uint64_t *)malloc(sizeof(uint64_t) * (ct->header.nblocks + 1));
+
+	start = nowSec();
+	for(b = 0; readTrace(&trace, &addr, &rw) != EOF; ) {
+		if(n == ct->index[b].firstRecord + ct->index[b].nrecords) {
+			hash[b++] = h;
+			h = 0;
+		}
+		h = recordHash(h, addr, rw, trace.time);
+		n++;
+	}
+	if(ct->header.nblocks)
+		hash[b] = h;
+	tSeq = nowSec() - start;
+
+	run.trace = &trace;
+	run.hash = (uint64_t *)calloc(ct->header.nblocks + 1, sizeof(uint64_t));
+	run.failed = 0;
+	for(b = 0; b < ct->header.nblocks; b++)
+		work[b] = ct->index[b].storedSize;
+	start = nowSec();
+	runTaskPool((int)ct->header.nblocks, work, decodeBlockTask, &run);
+	tPar = nowSec() - start;
+
+	printf("**** %s *****\n", name);
+	printf("sequential %llu records %.3f sec %.2f M records/sec%s\n", (unsigned long long)n, tSeq, n / tSeq / 1e6,
+			ct->header.flags & CTRACE_ZLIB ? " (zlib)" : "");
+	printf("parallel   %llu blocks %.3f sec %.2f M records/sec (x%.1f)\n", (unsigned long long)ct->header.nblocks, tPar,
+			n / tPar / 1e6, tSeq / tPar);
+	if(n != ct->header.nrecords || run.failed || memcmp(hash, run.hash, sizeof(uint64_t) * ct->header.nblocks)) {
+		printf("MISMATCH: block decode differs from the streaming decode\n");
+		ret = -1;
+	}
+	else
+		printf("blocks match the streaming decode\n");
+	free(hash);
+	free(work);
+	free(run.hash);
+	closeTrace(&trace);
+	return ret;
+}
+
+// text trace parsing 속도 측정. fscanf와 fast parser로 같은 파일을 읽어서 속도와 (addr, rw) stream을 비교
+int parseThroughput(const char *name) {
+	struct traceFile trace;
+	FILE *fp;
+	uint64_t addr;
+	char rw;
+	uint64_t nScanf = 0, nFast = 0, hScanf = 0, hFast = 0;
+	double start, tScanf, tFast;
+
+	if(openTrace(&trace, name, 0) == 0 && trace.format == TRACE_COMPRESSED) {
+		closeTrace(&trace);
+		return decodeThroughput(name);
+	}
+	if((fp = fopen(name, "r")) == NULL || openTrace(&trace, name, 0) != 0 || trace.format != TRACE_TEXT) {
+		printf("%s is not a readable text trace\n", name);
+		return -1;
+	}
+
+	start = nowSec();
+	while(fscanf(fp, "%" SCNx64 " %c", &addr, &rw) != EOF) {
+		hScanf = ((hScanf ^ addr) * 0x100000001b3ULL ^ (unsigned char)rw) * 0x100000001b3ULL;
+		nScanf++;
+	}
+	tScanf = nowSec() - start;
+	fclose(fp);
+
+	start = nowSec();
+	while(readTrace(&trace, &addr, &rw) != EOF) {
+		hFast = ((hFast ^ addr) * 0x100000001b3ULL ^ (unsigned char)rw) * 0x100000001b3ULL;
+		nFast++;
+	}
+	tFast = nowSec() - start;
+	closeTrace(&trace);
+
+	printf("**** %s *****\n", name);
+	printf("fscanf      %llu lines %.3f sec %.2f M lines/sec\n", (unsigned long long)nScanf, tScanf, nScanf / tScanf / 1e6);
+	printf("fast parser %llu lines %.3f sec %.2f M lines/sec (x%.1f%s)\n", (unsigned long long)nFast, tFast, nFast / tFast / 1e6,
+			tScanf / tFast,
+#ifdef __SSSE3__
+			", SSSE3"
+#else
+			""
+#endif
+			);
+	if(nScanf != nFast || hScanf != hFast) {
+		printf("MISMATCH: fast parser stream differs from fscanf\n");
+		return -1;
+	}
+	printf("stream matches fscanf\n");
+	return 0;
+}
+
+// trace를 연 뒤 procTable 초기화. 시뮬레이터 instance들은 여기서 trace 정보를 복사해간다
+void initProcTable(struct procEntry *procTable, char **traceNames) {
+	int i;
+	for(i = 0; i < numProcess; i++) {
+		procTable[i].traceName = traceNames[i];
+		procTable[i].pid = i;
+		procTable[i].ntraces = 0;
+		procTable[i].num2ndLevelPageTable = 0;
+		procTable[i].numIHTConflictAccess = 0;
+		procTable[i].numIHTNULLAccess = 0;
+		procTable[i].numIHTNonNULLAcess = 0;
+		procTable[i].numPageFault = 0;
+		procTable[i].numPageHit = 0;
+		procTable[i].firstLevelPageTable = NULL;
+		procTable[i].eof_valid = 0;
+	}
+}
+
+#ifndef MEMSIM_LIBRARY
+void usage(char *name) {
+	printf("Usage : %s [-s|-j] [-t|-b] [-r policies] [-C fault,writeback[,mem[,fill]]] [-T tlb] [-I ipt] [-L bits] [-l e|w|frames] [-W tau[,interval[,sample]]] [-P pageBits] [-H threshold] [-F n|s|m[,degree]] [-M frames[,f|r[,threshold[,ns]]]] [-K bytes[,ways[,line[,c]]]] [-Q quantum[,weights]|t] [-S t|b[,f][,pid]] [-o file] [-R rate[,pages] [-v]] [-D readers[,depth[,batch]]] simType firstLevelBits PhysicalMemorySizeBits TraceFileNames\n", name);
+	printf("        %s -c TraceFileNames\n", name);
+	printf("        %s -z|-Z TraceFileNames\n", name);
+	printf("        %s -p TraceFileNames\n", name);
+	printf("        %s -m [-v] TraceFileNames\n", name);
+	printf("        %s -f PhysicalMemorySizeBits TraceFileNames\n", name);
+	printf("  simType : 0 one-level, 1 two-level, 2 inverted, 4 N-level radix with 64-bit addresses,\n");
+	printf("            anything else runs 0, 1 and 2\n");
+	printf("  -s : print every address translation\n");
+	printf("  -S : -s with an output format and filter: t text lines (the default) or b binary records (needs -o),\n");
+	printf("       f only page faults, and a process number to print only that process, e.g. -S b,f,2\n");
+	printf("  -o : write the translations of -s and -S to this file instead of stdout\n");
+	printf("  -j : decode the traces once and run all selected simulations concurrently\n");
+	printf("  -r : replacement policies to simulate, e.g. -r FLCSA\n");
+	printf("       F FIFO, L LRU, S second chance, C CLOCK, A ARC, O OPT (offline, builds a next-use index first),\n");
+	printf("       W working set, P page fault frequency (both size each process's resident set themselves)\n");
+	printf("       (default: FIFO and LRU for one-level, LRU for two-level and inverted)\n");
+	printf("  -C : I/O cost model in ns: page fault service, dirty page write-back, memory access, and a page read\n");
+	printf("       without a fault (prefetch, huge page fill) (default 8000000,8000000,100 and the fault service)\n");
+	printf("  -T : TLB in front of the page table: entries[,ways[,L|F|R[,a|f[,hitNs]]]]\n");
+	printf("       ways defaults to fully associative; L LRU, F FIFO, R random; a ASID tagged, f flush on process switch\n");
+	printf("       (number of sets must be a power of two)\n");
+	printf("  -I : inverted page table: c|o[,m|x|f[,slots]]\n");
+	printf("       c chained, o open addressing; m (vpn + pid) %% size, x mix64, f Fibonacci hash; \n");
+	printf("       slots defaults to the frame count (chained) or twice the frame count (open addressing)\n");
+	printf("  -L : bits per level of the N-level radix table from the top, e.g. 9,9,9,9 (x86-64 4-level, the default)\n");
+	printf("       or 9,9,9,9,9 (5-level, 57-bit); firstLevelBits is ignored for simType 4. Without -L the 48-bit\n");
+	printf("       address is split into 9-bit levels for the page size (3-level for 2M pages, 2-level for 1G pages)\n");
+	printf("  -l : local replacement: every process replaces only within its own frame quota, and the processes\n");
+	printf("       are simulated in parallel. e equal quotas, w proportional to each process's footprint (distinct pages),\n");
+	printf("       or a frame count per process, e.g. 256,512,256 (OPT is not available)\n");
+	printf("  -W : working set window tau, PFF fault interval and resident set sampling period, in references of the process\n");
+	printf("       (default 10000,100,10000)\n");
+	printf("  -P : page size bits, %d (4K, the default) to %d (1G); 12, 21 and 30 use kernels specialized for that size\n", PAGESIZEBITS, MAXPAGESIZEBITS);
+	printf("  -H : transparent huge pages for simType 0 and 4: once this many of the %d base pages of an aligned region\n", 1 << THP_ORDER);
+	printf("       are resident, the rest are filled in and the region is mapped by one huge page (one TLB entry);\n");
+	printf("       evicting any of its pages splits it again (OPT is not available)\n");
+	printf("  -F : prefetch on every miss (a fault or the first use of a prefetched page): n|s|m[,degree]\n");
+	printf("       n the next degree pages, s degree pages ahead along a stride seen twice in a row,\n");
+	printf("       m Markov, following the recorded next miss of each page degree times (default degree 4;\n");
+	printf("       prefetched pages are filled through the replacement policy; OPT is not available)\n");
+	printf("  -M : two-tier memory: a slow tier of this many frames below the physical memory (the fast tier).\n");
+	printf("       Pages evicted from the fast tier are demoted to the slow tier, and only its LRU evictions go to disk.\n");
+	printf("       A slow tier page is accessed in place until it is promoted: f after threshold accesses in the slow tier,\n");
+	printf("       r when accessed again within threshold references (default f,2); ns is the slow tier access time\n");
+	printf("       (default 300; the fast tier uses the -C memory access time). OPT is not available\n");
+	printf("  -K : physically indexed set-associative cache (L2/LLC) shared by all processes: bytes[,ways[,lineBytes[,c]]]\n");
+	printf("       (default 16-way, 64-byte lines; the number of sets must be a power of two). Misses that a fully\n");
+	printf("       associative LRU cache of the same size would hit are counted as conflict misses. c colors the FIFO and\n");
+	printf("       LRU victims: among as many oldest frames as there are page colors, the first frame whose cache color\n");
+	printf("       matches the page is replaced\n");
+	printf("  -Q : scheduler that interleaves the traces: round-robin with quantum accesses per turn (default 1),\n");
+	printf("       optionally times a weight per process, e.g. 100,1,4,1; or t to merge the traces by the timestamp\n");
+	printf("       in the third field of each record (the record number when a trace has none)\n");
+	printf("  TraceFileNames : text, binary or compressed (-z) traces; - reads a text trace from stdin, and a FIFO is read as it is written.\n");
+	printf("       Such streams are read once, so several simulations share one decode as with -j\n");
+	printf("  -D : decode the traces in this many reader threads into per-process lock-free rings of depth batches of\n");
+	printf("       batch accesses (default 8 and 4096); the simulation only takes decoded records in the same order.\n");
+	printf("       Producer stalls (ring full) and consumer stalls (ring empty) are reported per process\n");
+	printf("  -t : always replay text traces (no binary cache)\n");
+	printf("  -b : replay through the binary cache even for single-pass simTypes\n");
+	printf("  -c : convert text traces to binary traces <name>.bin and exit\n");
+	printf("  -z : compress traces to <name>.mct and exit: blocks of %d records, each record a varint of the page number\n", CTRACE_BLOCK);
+	printf("       delta and the R/W bit, a varint of the page offset delta and the timestamp delta when it is not 1.\n");
+	printf("       .mct files are read like any other trace, decoding one block at a time\n");
+	printf("  -Z : -z with every block also compressed by zlib (needs a build with -DMEMSIM_ZLIB -lz)\n");
+	printf("  -m : print the global LRU page faults for every physical memory size in one pass\n");
+	printf("  -R : sampled simulation (SHARDS): only pages whose hash falls below rate are simulated, with the frame count\n");
+	printf("       scaled by the rate, and fault counts are extrapolated from the sampled fault ratio with a 95%% bound.\n");
+	printf("       pages caps the sample at that many distinct pages, lowering the rate in a first pass if needed.\n");
+	printf("       Only F, L, S, C and A; not with -s, -l, -T, -H, -F, -M or -K\n");
+	printf("  -v : with -m, check the curve against oneLevelVMSim LRU at every size;\n");
+	printf("       with -R, also run the exact simulation and compare\n");
+	printf("  -f : page table memory for every firstLevelBits split, one-level and inverted, in one pass\n");
+	printf("  -p : measure text parser throughput (lines/sec) against fscanf and exit; for a .mct trace, the streaming\n");
+	printf("       decode against decoding its blocks in parallel\n");
+	exit(1);
+}
+
+int main(int argc, char *argv[]) {	// argc : main함수에 전달 된 인자의 개수. 인자를 아무것도 주지 않고 main함수 호출 시 argc=1 (호출 이름 때문.)
+									// argv : main함수로 전달 되는 데이터. 문자열의 형태를 띈다.
+	int i;
+	int argi = 1;				// option이 아닌 첫 번째 인자
+	int c_flag = 0, t_flag = 0, b_flag = 0, p_flag = 0, z_flag = 0;
+	int preferBinary;
+	char simType;
+	char **traceNames;
+	struct vmSim *sims;			// 실행할 시뮬레이션들
+	int nsims = 0, t;
+	char policies[16] = "";		// -r로 지정한 replacement policy들
+	int j_flag = 0, m_flag = 0, v_flag = 0, f_flag = 0;
+	int streamed = 0;			// stdin이나 FIFO처럼 한 번만 읽을 수 있는 trace가 있음
+	const char *sinkName = NULL;	// -o: translation 출력 파일
+	char localTypes[64], localPolicies[64];	// -l: 시뮬레이션별 page table 종류와 policy
+	int simFrames, ret = 0;		// simFrames: 시뮬레이터의 frame 수 (-R이면 sampling rate만큼 줄인다)
+	uint64_t sampleThreshold = UINT64_MAX;
+	double rate;
+
+	// option 확인
+	for(; argi < argc && argv[argi][0] == '-' && argv[argi][1] != '\0'; argi++) {
+		if(!strcmp(argv[argi], "-s")) s_flag = 1;		// [-s] 인자 확인하여 s_flag 초기화.
+		else if(!strcmp(argv[argi], "-c")) c_flag = 1;
+		else if(!strcmp(argv[argi], "-z")) z_flag = 1;
+		else if(!strcmp(argv[argi], "-Z")) z_flag = 2;
+		else if(!strcmp(argv[argi], "-t")) t_flag = 1;
+		else if(!strcmp(argv[argi], "-b")) b_flag = 1;
+		else if(!strcmp(argv[argi], "-p")) p_flag = 1;
+		else if(!strcmp(argv[argi], "-j")) j_flag = 1;
+		else if(!strcmp(argv[argi], "-m")) m_flag = 1;
+		else if(!strcmp(argv[argi], "-v")) v_flag = 1;
+		else if(!strcmp(argv[argi], "-f")) f_flag = 1;
+		else if(!strcmp(argv[argi], "-C") && argi + 1 < argc) {
+			if(sscanf(argv[++argi], "%lf,%lf,%lf,%lf", &cost.faultService, &cost.writeBack, &cost.memAccess, &cost.fillRead) < 2)
+				usage(argv[0]);
+		}
+		else if(!strcmp(argv[argi], "-T") && argi + 1 < argc) {
+			char mode = 'a';
+			tlbConf.ways = 0;
+			if(sscanf(argv[++argi], "%d,%d,%c,%c,%lf", &tlbConf.entries, &tlbConf.ways, &tlbConf.policy, &mode, &tlbConf.hitNs) < 1)
+				usage(argv[0]);
+			if(tlbConf.ways == 0)
+				tlbConf.ways = tlbConf.entries;
+			tlbConf.asid = mode == 'a';
+			if(tlbConf.entries <= 0 || tlbConf.ways <= 0 || tlbConf.entries % tlbConf.ways != 0
+					|| ((tlbConf.entries / tlbConf.ways) & (tlbConf.entries / tlbConf.ways - 1)) != 0
+					|| strchr("LFR", tlbConf.policy) == NULL || (mode != 'a' && mode != 'f')) {
+				printf("bad TLB configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-I") && argi + 1 < argc) {
+			if(sscanf(argv[++argi], "%c,%c,%d", &iptConf.backend, &iptConf.hash, &iptConf.slots) < 1
+					|| strchr("co", iptConf.backend) == NULL || strchr("mxf", iptConf.hash) == NULL || iptConf.slots < 0) {
+				printf("bad inverted table configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+			iptConf.set = 1;
+		}
+		else if(!strcmp(argv[argi], "-L") && argi + 1 < argc) {
+			char *p = argv[++argi], *end;
+			radixConf.levels = 0;
+			radixConf.vaBits = 0;		// page offset bit 수는 option을 다 읽은 뒤 더한다
+			radixConf.set = 1;
+			while(radixConf.levels < RADIX_MAXLEVELS) {
+				radixConf.bits[radixConf.levels] = (int)strtol(p, &end, 10);
+				if(end == p || radixConf.bits[radixConf.levels] < 1 || radixConf.bits[radixConf.levels] > 24)
+					break;
+				radixConf.vaBits += radixConf.bits[radixConf.levels++];
+				if(*end != ',')
+					break;
+				p = end + 1;
+			}
+			// vpn이 pageKey에 들어가야 하므로 48bit까지
+			if(radixConf.levels == 0 || *end != '\0' || radixConf.vaBits > PAGEKEY_PIDSHIFT) {
+				printf("bad radix page table levels %s\n", argv[argi]); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-P") && argi + 1 < argc) {
+			pageSizeBits = atoi(argv[++argi]);
+			if(pageSizeBits < PAGESIZEBITS || pageSizeBits > MAXPAGESIZEBITS) {
+				printf("PageSizeBits %d should be between %d and %d\n", pageSizeBits, PAGESIZEBITS, MAXPAGESIZEBITS); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-H") && argi + 1 < argc) {
+			thpConf.threshold = atoi(argv[++argi]);
+			if(thpConf.threshold < 1 || thpConf.threshold > (1 << THP_ORDER)) {
+				printf("huge page promotion threshold should be between 1 and %d base pages\n", 1 << THP_ORDER); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-F") && argi + 1 < argc) {
+			if(sscanf(argv[++argi], "%c,%d", &prefetchConf.kind, &prefetchConf.degree) < 1
+					|| strchr("nsm", prefetchConf.kind) == NULL || prefetchConf.degree < 1) {
+				printf("bad prefetcher configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-M") && argi + 1 < argc) {
+			unsigned long long threshold = tierConf.threshold;
+			int n = sscanf(argv[++argi], "%d,%c,%llu,%lf", &tierConf.frames, &tierConf.promote, &threshold, &tierConf.slowNs);
+			tierConf.threshold = threshold;
+			if(n < 1 || tierConf.frames < 1 || tierConf.frames > (1 << MAXFRAMEBITS) || strchr("fr", tierConf.promote) == NULL
+					|| tierConf.threshold < 1 || tierConf.slowNs < 0) {
+				printf("bad memory tier configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-K") && argi + 1 < argc) {
+			char color = 0;
+			int sets;
+			sscanf(argv[++argi], "%d,%d,%d,%c", &cacheConf.bytes, &cacheConf.ways, &cacheConf.lineBytes, &color);
+			sets = cacheConf.ways > 0 && cacheConf.lineBytes > 0 ? cacheConf.bytes / cacheConf.ways / cacheConf.lineBytes : 0;
+			if(sets < 1 || (sets & (sets - 1)) || sets * cacheConf.ways * cacheConf.lineBytes != cacheConf.bytes
+					|| (cacheConf.lineBytes & (cacheConf.lineBytes - 1)) || (color != 0 && color != 'c')) {
+				printf("bad cache configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+			cacheConf.coloring = color == 'c';
+		}
+		else if(!strcmp(argv[argi], "-S") && argi + 1 < argc) {	// t|b[,f][,pid]
+			char *p = argv[++argi], *end;
+			s_flag = 1;
+			for(;;) {
+				if((*p == 't' || *p == 'b') && (p[1] == ',' || p[1] == '\0'))
+					sinkConf.format = *p++;
+				else if(*p == 'f' && (p[1] == ',' || p[1] == '\0')) {
+					sinkConf.faultsOnly = 1;
+					p++;
+				}
+				else {
+					sinkConf.pid = (int)strtol(p, &end, 10);
+					if(end == p || sinkConf.pid < 0) {
+						printf("bad translation output configuration %s\n", argv[argi]); usage(argv[0]);
+					}
+					p = end;
+				}
+				if(*p != ',')
+					break;
+				p++;
+			}
+			if(*p != '\0') {
+				printf("bad translation output configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-o") && argi + 1 < argc)
+			sinkName = argv[++argi];
+		else if(!strcmp(argv[argi], "-D") && argi + 1 < argc) {
+			if(sscanf(argv[++argi], "%d,%d,%d", &ingestConf.readers, &ingestConf.depth, &ingestConf.batch) < 1
+					|| ingestConf.readers < 1 || ingestConf.depth < 1 || ingestConf.batch < 1) {
+				printf("bad ingest configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+		}
+		else if(!strcmp(argv[argi], "-R") && argi + 1 < argc) {
+			unsigned long long smax = 0;
+			if(sscanf(argv[++argi], "%lf,%llu", &sampleConf.rate, &smax) < 1 || sampleConf.rate <= 0 || sampleConf.rate > 1
+					|| (strchr(argv[argi], ',') != NULL && smax == 0)) {
+				printf("bad sampling configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+			sampleConf.smax = smax;
+		}
+		else if(!strcmp(argv[argi], "-Q") && argi + 1 < argc) {
+			char *p = argv[++argi], *end;
+			if(!strcmp(p, "t"))
+				schedConf.mode = 't';
+			else {	// quantum[,weight,...]
+				schedConf.mode = 'r';
+				schedConf.quantum = (int)strtol(p, &end, 10);
+				if(end == p || schedConf.quantum < 1) {
+					printf("bad scheduler configuration %s\n", argv[argi]); usage(argv[0]);
+				}
+				if(*end == ',')
+					schedConf.weight = (int *)malloc(sizeof(int) * (strlen(p) / 2 + 1));
+				while(*end == ',') {
+					p = end + 1;
+					schedConf.weight[schedConf.nweight] = (int)strtol(p, &end, 10);
+					if(end == p || schedConf.weight[schedConf.nweight] < 1) {
+						printf("bad scheduler weight %s\n", argv[argi]); usage(argv[0]);
+					}
+					schedConf.nweight++;
+				}
+				if(*end != '\0') {
+					printf("bad scheduler configuration %s\n", argv[argi]); usage(argv[0]);
+				}
+			}
+		}
+		else if(!strcmp(argv[argi], "-W") && argi + 1 < argc) {
+			unsigned long long tau, interval = allocConf.pffInterval, sample = allocConf.sample;
+			if(sscanf(argv[++argi], "%llu,%llu,%llu", &tau, &interval, &sample) < 1 || tau == 0 || interval == 0 || sample == 0) {
+				printf("bad working set configuration %s\n", argv[argi]); usage(argv[0]);
+			}
+			allocConf.tau = tau;
+			allocConf.pffInterval = interval;
+			allocConf.sample = sample;
+		}
+		else if(!strcmp(argv[argi], "-l") && argi + 1 < argc) {
+			char *p = argv[++argi], *end;
+			if(!strcmp(p, "e") || !strcmp(p, "w"))
+				localConf.alloc = *p;
+			else {	// 프로세스별 frame 수
+				localConf.alloc = 'u';
+				localConf.quota = (int *)malloc(sizeof(int) * (strlen(p) / 2 + 1));
+				for(;;) {
+					localConf.quota[localConf.nquota] = (int)strtol(p, &end, 10);
+					if(end == p || localConf.quota[localConf.nquota] < 1) {
+						printf("bad frame quota %s\n", argv[argi]); usage(argv[0]);
+					}
+					localConf.nquota++;
+					if(*end != ',')
+						break;
+					p = end + 1;
+				}
+				if(*end != '\0') {
+					printf("bad frame quota %s\n", argv[argi]); usage(argv[0]);
+				}
+			}
+		}
+		else if(!strcmp(argv[argi], "-r") && argi + 1 < argc) {
+			const char *p;
+			for(p = argv[++argi]; *p; p++) {
+				if(*p == ',')
+					continue;
+				if(findPolicy(*p) == NULL || strlen(policies) + 1 >= sizeof(policies)) {
+					printf("unknown replacement policy %c\n", *p); usage(argv[0]);
+				}
+				strncat(policies, p, 1);
+			}
+		}
+		else usage(argv[0]);
+	}
+
+	if(cost.fillRead < 0)	// fault 없이 읽는 page도 따로 주지 않으면 fault와 같은 비용
+		cost.fillRead = cost.faultService;
+
+	if(sinkConf.format == 'b' && sinkName == NULL) {	// stdout에는 report가 섞인다
+		printf("binary translation records need -o file\n"); exit(1);
+	}
+	if(sinkName != NULL) {
+		struct xlateHeader header;
+		if((sinkConf.fp = fopen(sinkName, "wb")) == NULL) {
+			printf("cannot open %s\n", sinkName); exit(1);
+		}
+		if(sinkConf.format == 'b') {
+			memcpy(header.magic, XLATE_MAGIC, 4);
+			header.version = XLATE_VERSION;
+			header.recordSize = sizeof(struct xlateRecord);
+			header.reserved = 0;
+			fwrite(&header, sizeof(header), 1, sinkConf.fp);
+		}
+	}
+
+	// -L이 없으면 x86-64처럼 48bit virtual address를 위 level부터 9bit씩 나눈다 (2MB page는 3-level, 1GB page는 2-level)
+	if(!radixConf.set) {
+		radixConf.levels = (48 - pageSizeBits + 8) / 9;
+		for(i = 0; i < radixConf.levels; i++)
+			radixConf.bits[i] = 9;
+		radixConf.bits[0] = 48 - pageSizeBits - 9 * (radixConf.levels - 1);	// 나머지는 가장 위 level
+		radixConf.vaBits = 48;
+	}
+	else
+		radixConf.vaBits += pageSizeBits;
+
+	if(c_flag) {	// text trace들을 binary로 변환만 하고 종료
+		char binName[4096];
+		if(argi == argc)
+			usage(argv[0]);
+		for(; argi < argc; argi++) {
+			snprintf(binName, sizeof(binName), "%s.bin", argv[argi]);
+			if(convertTrace(argv[argi], binName) != 0) {
+				printf("failed to convert %s\n", argv[argi]); exit(1);
+			}
+			printf("%s -> %s\n", argv[argi], binName);
+		}
+		return(0);
+	}
+
+	if(z_flag) {	// trace들을 압축 trace로 변환만 하고 종료
+		char ctName[4096];
+		if(argi == argc)
+			usage(argv[0]);
+		for(; argi < argc; argi++) {
+			snprintf(ctName, sizeof(ctName), "%s.mct", argv[argi]);
+			if(compressTrace(argv[argi], ctName, z_flag == 2) != 0) {
+				printf("failed to compress %s\n", argv[argi]); exit(1);
+			}
+			printf("%s -> %s\n", argv[argi], ctName);
+		}
+		return(0);
+	}
+
+	if(p_flag) {	// text parser 처리량만 측정하고 종료
+		int ret = 0;
+		if(argi == argc)
+			usage(argv[0]);
+		for(; argi < argc; argi++)
+			if(parseThroughput(argv[argi]) != 0)
+				ret = 1;
+		return(ret);
+	}
+
+	if(m_flag) {	// miss ratio curve만 구하고 종료
+		if(argi == argc)
+			usage(argv[0]);
+		numProcess = argc - argi;
+		if(prefetchConf.kind || thpConf.threshold || tierConf.frames) {	// stack distance는 access한 page만 들어오는 demand paging
+			printf("-m cannot be used with -F, -H or -M\n"); exit(1);
+		}
+		if(schedConf.weight != NULL && schedConf.nweight != numProcess) {
+			printf("-Q gives %d weights for %d processes\n", schedConf.nweight, numProcess); exit(1);
+		}
+		struct procEntry mrcProcTable[numProcess];
+		for(i = 0; i < numProcess; i++) {
+			printf("process %d opening %s\n",i,argv[argi + i]);
+			if(openTrace(&mrcProcTable[i].trace, argv[argi + i], !t_flag && (b_flag || v_flag)) != 0) {
+				printf("cannot open %s\n", argv[argi + i]); exit(1);
+			}
+			streamed |= mrcProcTable[i].trace.stream;
+		}
+		if(streamed && v_flag) {	// 검증은 trace를 크기마다 다시 읽는다
+			printf("-v needs trace files, not streams\n"); exit(1);
+		}
+		initProcTable(mrcProcTable, &argv[argi]);
+		s_flag = 0;
+		ret = missRatioCurve(mrcProcTable, v_flag) == 0 ? 0 : 1;
+		for(i = 0; i < numProcess; i++)
+			closeTrace(&mrcProcTable[i].trace);
+		return(ret);
+	}
+
+	if(f_flag) {	// page table 메모리 분석만 하고 종료
+		if(argc - argi < 2)
+			usage(argv[0]);
+		phyMemSizeBits = atoi(argv[argi]);
+		if (phyMemSizeBits < pageSizeBits) {
+			printf("PhysicalMemorySizeBits %d should be larger than PageSizeBits %d\n",phyMemSizeBits,pageSizeBits); exit(1);
+		}
+		if (phyMemSizeBits - pageSizeBits > MAXFRAMEBITS) {	// frame 번호는 PTE_FRAMEMASK에 들어가야 한다
+			printf("PhysicalMemorySizeBits %d is too Big (at most %d)\n",phyMemSizeBits,MAXFRAMEBITS + pageSizeBits); exit(1);
+		}
+		numProcess = argc - argi - 1;
+		struct procEntry fpProcTable[numProcess];
+		for(i = 0; i < numProcess; i++) {
+			printf("process %d opening %s\n",i,argv[argi + 1 + i]);
+			if(openTrace(&fpProcTable[i].trace, argv[argi + 1 + i], 0) != 0) {
+				printf("cannot open %s\n", argv[argi + 1 + i]); exit(1);
+			}
+		}
+		initProcTable(fpProcTable, &argv[argi + 1]);
+		pageTableFootprint(fpProcTable, 1 << (phyMemSizeBits - pageSizeBits));
+		for(i = 0; i < numProcess; i++)
+			closeTrace(&fpProcTable[i].trace);
+		return(0);
+	}
+
+	if (argc - argi < 4)	//인자 잘못 넣었을 경우 출력.
+		usage(argv[0]);
+	if(s_flag && j_flag) {
+		printf("-s cannot be used with -j\n"); exit(1);
+	}
+	if(localConf.alloc && s_flag) {	// 프로세스들을 동시에 시뮬레이션하므로 translation 순서가 섞인다
+		printf("-s cannot be used with -l\n"); exit(1);
+	}
+	if(localConf.alloc && strchr(policies, 'O') != NULL) {	// next-use index는 전체 round-robin 순서 기준
+		printf("OPT cannot be used with -l\n"); exit(1);
+	}
+	if(localConf.alloc && (strchr(policies, 'W') != NULL || strchr(policies, 'P') != NULL)) {	// 둘은 frame 수를 스스로 정한다
+		printf("working set and PFF allocation cannot be used with -l\n"); exit(1);
+	}
+
+	// 사용할 변수들 생성 및 초기화.
+	numProcess = argc - argi - 3;	// 프로세스의 개수 초기화 (main함수가 받는 인자의 개수에서 traceFileName이 아닌 개수를 뺀다)
+	struct procEntry procTable[numProcess];	// 프로세스의 개수만큼 procEntry 생성
+	simType = *argv[argi];
+	firstLevelBits = atoi(argv[argi + 1]);
+	phyMemSizeBits = atoi(argv[argi + 2]);
+	traceNames = &argv[argi + 3];
+
+	if (phyMemSizeBits < pageSizeBits) {
+		printf("PhysicalMemorySizeBits %d should be larger than PageSizeBits %d\n",phyMemSizeBits,pageSizeBits); exit(1);
+	}
+	if (phyMemSizeBits - pageSizeBits > MAXFRAMEBITS) {	// frame 번호는 PTE_FRAMEMASK에 들어가야 한다
+		printf("PhysicalMemorySizeBits %d is too Big (at most %d)\n",phyMemSizeBits,MAXFRAMEBITS + pageSizeBits); exit(1);
+	}
+	if (VIRTUALADDRBITS - pageSizeBits - firstLevelBits <= 0 ) {
+		printf("firstLevelBits %d is too Big for the 2nd level page system\n",firstLevelBits); exit(1);
+	}
+	if(schedConf.weight != NULL && schedConf.nweight != numProcess) {
+		printf("-Q gives %d weights for %d processes\n", schedConf.nweight, numProcess); exit(1);
+	}
+	if(prefetchConf.kind && strchr(policies, 'O') != NULL) {	// next-use index는 access된 page만 들어온다고 가정한다
+		printf("OPT cannot be used with -F\n"); exit(1);
+	}
+	if(tierConf.frames && strchr(policies, 'O') != NULL) {	// slow tier에서 그대로 access하면 next-use index와 어긋난다
+		printf("OPT cannot be used with -M\n"); exit(1);
+	}
+	if(tierConf.frames && localConf.alloc) {	// slow tier는 모든 프로세스가 같이 쓴다
+		printf("-M cannot be used with -l\n"); exit(1);
+	}
+	if(cacheConf.bytes && localConf.alloc) {	// cache도 모든 프로세스가 같이 쓴다
+		printf("-K cannot be used with -l\n"); exit(1);
+	}
+	if(cacheConf.lineBytes > (1 << pageSizeBits)) {
+		printf("cache lines of %d bytes are larger than a page\n", cacheConf.lineBytes); exit(1);
+	}
+	if(sampleConf.rate) {	// sample에는 sampling한 page의 access만 들어오므로 전체 access stream이나 이웃 page가 필요한 기능은 쓸 수 없다
+		if(s_flag || localConf.alloc || tlbConf.entries || thpConf.threshold || prefetchConf.kind || tierConf.frames || cacheConf.bytes) {
+			printf("-R cannot be used with -s, -l, -T, -H, -F, -M or -K\n"); exit(1);
+		}
+		if(strpbrk(policies, "OWP") != NULL) {	// OPT index와 working set window는 access 수 기준
+			printf("OPT, working set and PFF cannot be used with -R\n"); exit(1);
+		}
+	}
+	if(thpConf.threshold) {
+		if(simType != '0' && simType != '4') {
+			printf("-H needs simType 0 or 4\n"); exit(1);
+		}
+		if(strchr(policies, 'O') != NULL) {	// next-use index는 access된 page만 들어온다고 가정한다
+			printf("OPT cannot be used with -H\n"); exit(1);
+		}
+		if(pageSizeBits + THP_ORDER > (simType == '4' ? radixConf.vaBits : VIRTUALADDRBITS)) {
+			printf("a huge page of %d bits does not fit in the virtual address space\n", pageSizeBits + THP_ORDER); exit(1);
+		}
+	}
+
+	// simType 0과 3 이상은 trace를 여러 번 replay하므로 binary cache가 기본 (-j이면 한 번만 읽는다).
+	// 고정 크기 sample과 sampling 검증도 trace를 여러 번 읽는다
+	preferBinary = !t_flag && (b_flag || (!j_flag && simType != '1' && simType != '2' && simType != '4')
+			|| (sampleConf.rate && (sampleConf.smax || v_flag)));
+
+	// initialize procTable for memory simulations
+	for(i = 0; i < numProcess; i++) {
+		// opening a tracefile for the process
+		printf("process %d opening %s\n",i,traceNames[i]);
+		if(openTrace(&procTable[i].trace, traceNames[i], preferBinary) != 0) {
+			printf("cannot open %s\n", traceNames[i]); exit(1);
+		}
+		streamed |= procTable[i].trace.stream;
+	}
+	// stream은 rewind할 수 없으므로 trace를 여러 번 읽는 기능은 쓸 수 없다. 시뮬레이션이 여럿이면 -j처럼 한 번 읽어서 나눠준다
+	if(streamed && (strchr(policies, 'O') != NULL || localConf.alloc || (sampleConf.rate && (sampleConf.smax || v_flag)))) {
+		printf("OPT, -l and -R with pages or -v read the traces more than once and need trace files, not streams\n"); exit(1);
+	}
+
+	nFrame = (1<<(phyMemSizeBits-pageSizeBits)); assert(nFrame>0);
+
+	printf("\nNum of Frames %d Physical Memory Size %lld bytes\n",nFrame, (1LL<<phyMemSizeBits));
+	if(iptConf.backend == 'o' && iptConf.slots != 0 && iptConf.slots <= nFrame) {	// 빈 slot이 없으면 probe가 끝나지 않는다
+		printf("open addressing inverted table needs more than %d slots\n", nFrame); exit(1);
+	}
+	if(schedConf.mode == 't')
+		printf("Scheduler merges the traces by timestamp\n");
+	else if(schedConf.quantum != 1 || schedConf.weight != NULL)
+		printf("Scheduler round-robin, quantum %d accesses%s\n", schedConf.quantum, schedConf.weight != NULL ? " times the process weight" : "");
+	if(pageSizeBits != PAGESIZEBITS)
+		printf("Page size %llu bytes\n", 1ULL << pageSizeBits);
+	if(tierConf.frames) {
+		printf("Slow tier %d frames, %.0f ns per access, promoted ", tierConf.frames, tierConf.slowNs);
+		if(tierConf.promote == 'f')
+			printf("after %llu accesses\n", (unsigned long long)tierConf.threshold);
+		else
+			printf("when accessed again within %llu references\n", (unsigned long long)tierConf.threshold);
+	}
+	if(cacheConf.bytes)
+		printf("Cache %d bytes %d-way %d-byte lines%s\n", cacheConf.bytes, cacheConf.ways, cacheConf.lineBytes,
+				cacheConf.coloring ? ", page coloring" : "");
+	if(thpConf.threshold)
+		printf("Transparent huge pages of %llu bytes, promoted at %d resident base pages\n", 1ULL << (pageSizeBits + THP_ORDER), thpConf.threshold);
+
+	initProcTable(procTable, traceNames);
+
+	simFrames = nFrame;
+	if(sampleConf.rate) {	// sampling rate만큼 frame도 줄인다
+		uint64_t npages;
+		sampleThreshold = sampleConf.rate >= 1 ? UINT64_MAX : (uint64_t)ldexp(sampleConf.rate, 64);
+		if(sampleConf.smax) {
+			sampleThreshold = sampleThresholdFixed(procTable, simType, sampleThreshold, sampleConf.smax, &npages);
+			printf("Fixed-size sample of %llu pages (at most %llu)\n", (unsigned long long)npages, (unsigned long long)sampleConf.smax);
+		}
+		rate = sampleThreshold == UINT64_MAX ? 1.0 : ldexp((double)sampleThreshold, -64);
+		simFrames = (int)(nFrame * rate + 0.5);
+		if(simFrames < 1)
+			simFrames = 1;
+		printf("Sampling pages at rate %.6f, %d frames\n", rate, simFrames);
+	}
+
+	if(strchr(policies, 'O') != NULL) {	// OPT는 미리 next-use index가 필요
+		if(buildNextUseIndex(procTable, simType, optIndexName, sizeof(optIndexName)) != 0) {
+			printf("cannot build the OPT next-use index\n"); exit(1);
+		}
+	}
+
+	// -r이 없으면 one-level은 FIFO와 LRU, two-level과 inverted는 LRU
+	sims = (struct vmSim *)malloc(sizeof(struct vmSim) * 3 * (strlen(policies) + 2));
+	memset(localTypes, 0, sizeof(localTypes));
+	memset(localPolicies, 0, sizeof(localPolicies));
+	for(t = 0; t < 5; t++) {
+		const char *list = policies[0] ? policies : (t == 0 ? "FL" : "L");
+		if(simType == '0' || simType == '1' || simType == '2' || simType == '4') {
+			if(simType != '0' + t)
+				continue;
+		}
+		else if(t > 2)	// 그 밖의 simType은 32bit page table들을 모두 수행
+			continue;
+		for(; *list; list++) {
+			if(localConf.alloc) {	// local replacement의 instance는 프로세스마다 runLocalVMSims가 만든다
+				localTypes[nsims] = '0' + t;
+				localPolicies[nsims++] = *list;
+			}
+			else
+				initVMSim(&sims[nsims++], '0' + t, *list, procTable, numProcess, simFrames);
+		}
+	}
+
+	if(optIndexName[0] != '\0')	// OPT instance들이 이미 열었으므로 지워도 된다
+		unlink(optIndexName);
+	if(streamed && s_flag && nsims > 1) {
+		printf("-s with a streamed trace runs one simulation; choose it with simType and -r\n"); exit(1);
+	}
+
+	if(sampleConf.rate) {
+		if(runSampledVMSims(sims, nsims, procTable, sampleThreshold, v_flag) != 0)
+			ret = 1;
+	}
+	else if(localConf.alloc) {
+		if(runLocalVMSims(localTypes, localPolicies, nsims, procTable, preferBinary) != 0)
+			exit(1);
+		nsims = 0;
+	}
+	else if((j_flag || streamed) && nsims > 1)
+		runVMSimsParallel(sims, nsims, procTable);	// trace를 한 번만 읽고 모든 시뮬레이션을 동시에 수행
+	else
+		runVMSims(sims, nsims, procTable);
+
+	for(i = 0; i < nsims; i++)
+		freeVMSim(&sims[i]);
+	free(sims);
+	free(localConf.quota);
+	free(schedConf.weight);
+	if(sinkConf.fp != NULL && fclose(sinkConf.fp) != 0) {
+		printf("cannot write %s\n", sinkName);
+		ret = 1;
+	}
 
 	for(i = 0; i<numProcess; i++)
-		fclose(procTable[i].tracefp);
+		closeTrace(&procTable[i].trace);
 
-	return(0);
+	return(ret);
 }
+#endif
@@ -0,0 +1,46 @@
+// Virual Memory Management Simulator library
+// memsim.c를 -DMEMSIM_LIBRARY로 compile하면 main 없이 시뮬레이터를 다른 프로그램에 넣어서 쓸 수 있다.
+// instance마다 자기 page table, frame table과 통계를 가지므로 여러 instance를 여러 thread에서 따로 돌려도 된다.
+// TLB, THP, prefetch 같은 추가 기능의 설정(tlbConf 등)은 모든 instance가 같이 읽는 전역 설정이다
+
+#ifndef MEMSIM_H
+#define MEMSIM_H
+
+#include <stdint.h>
+
+struct vmSim;
+
+struct vmSimConfig {
+	char type;					// '0' one-level, '1' two-level, '2' inverted, '4' N-level radix
+	char policy;				// replacement policy: F, L, S, C, A, W, P (OPT는 trace 전체가 필요해서 쓸 수 없다)
+	int nProc;					// 프로세스 수. access의 pid는 0 ~ nProc-1
+	int nFrame;					// physical memory의 frame 수
+	int pageBits;				// page offset bit 수 (12 ~ 30). '4'는 -P로 정한 page 크기만 된다
+	int firstLevelBits;			// two-level의 1st level index bit 수
+	int verbose;				// 1이면 access마다 translation을 stdout에 출력
+};
+
+struct vmSimStats {
+	long long ntraces;			// access 수
+	long long numPageFault;
+	long long numPageHit;
+	long long numSlowHit;		// slow tier에서 찾은 access (-M)
+	long long numCleanEviction;
+	long long numDirtyEviction;
+	long long numTLBHit;
+	long long numTLBMiss;
+};
+
+// 설정이 잘못됐으면 NULL
+struct vmSim *vmSimCreate(const struct vmSimConfig *conf);
+// 프로세스 pid의 access 하나. rw는 'R' or 'W'
+void vmSimStep(struct vmSim *sim, int pid, uint64_t addr, char rw);
+// 프로세스 pid의 연속된 access n개
+void vmSimStepBatch(struct vmSim *sim, int pid, const uint64_t *addrs, const char *rws, int n);
+// 프로세스 pid의 지금까지의 통계. pid가 범위 밖이면 -1
+int vmSimGetStats(struct vmSim *sim, int pid, struct vmSimStats *stats);
+// CLI와 같은 형식으로 결과를 stdout에 출력
+void vmSimReport(struct vmSim *sim);
+void vmSimDestroy(struct vmSim *sim);
+
+#endif